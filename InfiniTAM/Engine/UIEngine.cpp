@@ -219,7 +219,7 @@ void UIEngine::glutKeyUpFunction(unsigned char key, int x, int y)
 		break;
 	case 'w':
 		printf("saving mesh to disk ...");
-		uiEngine->SaveSceneToMesh("mesh.stl");
+		uiEngine->SaveSceneToMesh("mesh.ply");
 		printf(" done\n");
 		break;
 	default:
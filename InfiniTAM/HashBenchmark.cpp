@@ -0,0 +1,204 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+// Compares the chained voxel block hash (ITMVoxelBlockHash) with the open-addressing one
+// (ITMVoxelBlockOpenHash) at several load factors. For each table, this reports the time it takes
+// to insert the blocks, the time it takes to look them up (both existing and missing blocks), and
+// the average number of entries inspected per lookup.
+//
+// Usage: InfiniTAM_hashbench [log2 of the table size, default 20]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h"
+
+using namespace ITMLib::Objects;
+
+namespace {
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double elapsedMs(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Vector3iHash {
+	size_t operator()(const Vector3i &v) const { return static_cast<size_t>(hashIndex(v, 0x7fffffff)); }
+};
+
+struct Vector3iEq {
+	bool operator()(const Vector3i &a, const Vector3i &b) const { return a == b; }
+};
+
+/// Random, distinct block positions. Half of them are used as hits, and half as misses.
+std::vector<Vector3i> generateBlocks(int count, unsigned int seed) {
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> coord(-1024, 1023);
+	std::unordered_set<Vector3i, Vector3iHash, Vector3iEq> seen;
+	std::vector<Vector3i> blocks;
+	blocks.reserve(count);
+
+	while (static_cast<int>(blocks.size()) < count) {
+		Vector3i pos(coord(rng), coord(rng), coord(rng));
+		if (seen.insert(pos).second) blocks.push_back(pos);
+	}
+	return blocks;
+}
+
+void resetEntries(ITMHashEntry *entries, int noEntries) {
+	ITMHashEntry emptyEntry;
+	memset(&emptyEntry, 0, sizeof(ITMHashEntry));
+	emptyEntry.ptr = -2;
+	for (int i = 0; i < noEntries; ++i) entries[i] = emptyEntry;
+}
+
+/// Inserts a block the way the allocation in ITMSceneReconstructionEngine does: into the bucket
+/// itself if it is empty, and at the end of the bucket's chain in the excess list otherwise.
+bool insertChained(ITMVoxelBlockHash &index, const Vector3i &pos, int ptr, int &excessUsed) {
+	ITMHashEntry *entries = index.GetEntries();
+	int idx = hashIndex(pos, index.getIndexData()->hashMask);
+
+	if (entries[idx].ptr < -1) {
+		entries[idx].pos = Vector3s(pos.x, pos.y, pos.z); entries[idx].ptr = ptr; entries[idx].offset = 0;
+		return true;
+	}
+
+	while (entries[idx].offset >= 1) idx = index.getBucketNum() + entries[idx].offset - 1;
+
+	if (excessUsed >= index.getExcessListSize()) return false;
+
+	int excessIdx = excessUsed++;
+	ITMHashEntry &child = entries[index.getBucketNum() + excessIdx];
+	child.pos = Vector3s(pos.x, pos.y, pos.z); child.ptr = ptr; child.offset = 0;
+	entries[idx].offset = excessIdx + 1;
+	return true;
+}
+
+bool insertOpen(ITMVoxelBlockOpenHash &index, const Vector3i &pos, int ptr) {
+	int freeSlot;
+	if (findBlockOrFreeSlot(index.getIndexData(), pos, freeSlot) >= 0 || freeSlot < 0) return false;
+
+	ITMHashEntry &entry = index.GetEntries()[freeSlot];
+	entry.pos = Vector3s(pos.x, pos.y, pos.z); entry.ptr = ptr; entry.offset = 0;
+	return true;
+}
+
+/// Number of entries inspected by findBlock on the chained table.
+int probeLengthChained(const ITMVoxelBlockHash::IndexData *voxelIndex, const Vector3i &pos) {
+	int idx = hashIndex(pos, voxelIndex->hashMask);
+	int length = 1;
+	while (!(IS_EQUAL3(voxelIndex->entries[idx].pos, pos) && voxelIndex->entries[idx].ptr >= 0)
+		   && voxelIndex->entries[idx].offset >= 1) {
+		idx = voxelIndex->bucketNum + voxelIndex->entries[idx].offset - 1;
+		length++;
+	}
+	return length;
+}
+
+/// Number of slots inspected by findBlock on the open-addressing table.
+int probeLengthOpen(const ITMVoxelBlockOpenHash::IndexData *voxelIndex, const Vector3i &pos) {
+	int slotIdx = hashIndex(pos, voxelIndex->slotMask);
+	for (int length = 1; length <= voxelIndex->slotNum; length++) {
+		const ITMHashEntry &entry = voxelIndex->entries[slotIdx];
+		if (entry.ptr < -1 || IS_EQUAL3(entry.pos, pos)) return length;
+		slotIdx = (slotIdx + 1) & voxelIndex->slotMask;
+	}
+	return voxelIndex->slotNum;
+}
+
+struct Result {
+	int failedInserts = 0;
+	double insertMs = 0.0, hitMs = 0.0, missMs = 0.0;
+	double hitProbe = 0.0, missProbe = 0.0;
+	long checksum = 0;
+};
+
+template<class TIndex, class TInsert, class TProbe>
+Result runBenchmark(TIndex &index, const std::vector<Vector3i> &hits, const std::vector<Vector3i> &misses,
+					TInsert insert, TProbe probeLength) {
+	Result result;
+	resetEntries(index.GetEntries(), index.noTotalEntries);
+
+	Clock::time_point start = Clock::now();
+	for (size_t i = 0; i < hits.size(); ++i) {
+		if (!insert(hits[i], static_cast<int>(i))) result.failedInserts++;
+	}
+	result.insertMs = elapsedMs(start);
+
+	const typename TIndex::IndexData *voxelIndex = index.getIndexData();
+
+	start = Clock::now();
+	for (const Vector3i &pos : hits) {
+		bool isFound = false;
+		result.checksum += findBlock(voxelIndex, pos, isFound);
+	}
+	result.hitMs = elapsedMs(start);
+
+	start = Clock::now();
+	for (const Vector3i &pos : misses) {
+		bool isFound = false;
+		result.checksum += findBlock(voxelIndex, pos, isFound);
+	}
+	result.missMs = elapsedMs(start);
+
+	for (const Vector3i &pos : hits) result.hitProbe += probeLength(voxelIndex, pos);
+	for (const Vector3i &pos : misses) result.missProbe += probeLength(voxelIndex, pos);
+	result.hitProbe /= hits.size();
+	result.missProbe /= misses.size();
+
+	return result;
+}
+
+void printResult(const char *name, float loadFactor, int noBlocks, const Result &result) {
+	printf("%-8s %5.2f %9d %9d %10.2f %10.2f %10.2f %9.3f %9.3f %12ld\n", name, loadFactor, noBlocks,
+		   result.failedInserts, result.insertMs, result.hitMs, result.missMs, result.hitProbe, result.missProbe,
+		   result.checksum);
+}
+
+}
+
+int main(int argc, char **argv) {
+	int log2TableSize = (argc > 1) ? atoi(argv[1]) : 20;
+	if (log2TableSize < 4 || log2TableSize > 26) {
+		fprintf(stderr, "The table size must be between 2^4 and 2^26.\n");
+		return EXIT_FAILURE;
+	}
+
+	// Both tables have the same number of main slots. As with the default settings, the chained
+	// table gets an extra excess list of a quarter of that size.
+	int tableSize = 1 << log2TableSize;
+	int excessListSize = tableSize / 4;
+	const float loadFactors[] = { 0.25f, 0.5f, 0.75f, 0.9f };
+
+	ITMVoxelBlockHash chained(MEMORYDEVICE_CPU, tableSize - 1, tableSize, excessListSize);
+	ITMVoxelBlockOpenHash open(MEMORYDEVICE_CPU, tableSize - 1, tableSize);
+
+	printf("Table size: %d slots (chained: +%d excess list entries), probe group size: %d\n\n",
+		   tableSize, excessListSize, SDF_OPEN_HASH_GROUP_SIZE);
+	printf("%-8s %5s %9s %9s %10s %10s %10s %9s %9s %12s\n", "table", "load", "blocks", "failed",
+		   "insert ms", "hit ms", "miss ms", "hit len", "miss len", "checksum");
+
+	for (float loadFactor : loadFactors) {
+		int noBlocks = static_cast<int>(loadFactor * tableSize);
+		std::vector<Vector3i> blocks = generateBlocks(2 * noBlocks, 42);
+		std::vector<Vector3i> hits(blocks.begin(), blocks.begin() + noBlocks);
+		std::vector<Vector3i> misses(blocks.begin() + noBlocks, blocks.end());
+
+		int excessUsed = 0;
+		Result chainedResult = runBenchmark(chained, hits, misses,
+			[&](const Vector3i &pos, int ptr) { return insertChained(chained, pos, ptr, excessUsed); },
+			probeLengthChained);
+		printResult("chained", loadFactor, noBlocks, chainedResult);
+
+		Result openResult = runBenchmark(open, hits, misses,
+			[&](const Vector3i &pos, int ptr) { return insertOpen(open, pos, ptr); },
+			probeLengthOpen);
+		printResult("open", loadFactor, noBlocks, openResult);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -24,8 +24,10 @@ _CPU_AND_GPU_CODE_ inline float computePerPixelEnergy(const THREADPTR(Vector4f)
 	Vector3f pt; bool dtIsFound;
 	pt = TO_VECTOR3(invM * inpt) * oneOverVoxelSize;
 
+	SDFSampler<TVoxel, typename TIndex::IndexData> sampler(voxelBlocks, index);
+
 	// faster but theoretically worse
-	float dt = readFromSDF_float_uninterpolated(voxelBlocks, index, pt, dtIsFound);
+	float dt = readFromSDF_float_uninterpolated(sampler, pt, dtIsFound);
 
 	//typename TIndex::IndexCache cache;
 	//float dt = readFromSDF_float_interpolated(voxelBlocks, index, pt, dtIsFound, cache);
@@ -36,9 +38,11 @@ _CPU_AND_GPU_CODE_ inline float computePerPixelEnergy(const THREADPTR(Vector4f)
 	return 4.0f * expdt / ((expdt + 1.0f)*(expdt + 1.0f));
 }
 
-template<class TVoxel, class TIndex>
-_CPU_AND_GPU_CODE_ inline Vector3f computeDDT(const CONSTPTR(Vector3f) &pt_f, const THREADPTR(TVoxel) *voxelBlocks,
-	const THREADPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, DEVICEPTR(bool) &ddtFound)
+/// \brief The central differences of the SDF around the voxel nearest to pt_f, read through
+///        sampler, which may already hold the blocks around it.
+template<class TVoxel, class TIndexData>
+_CPU_AND_GPU_CODE_ inline Vector3f computeDDT(const CONSTPTR(Vector3f) &pt_f, SDFSampler<TVoxel, TIndexData> &sampler,
+	DEVICEPTR(bool) &ddtFound)
 {
 	
 	Vector3f ddt;
@@ -47,21 +51,23 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeDDT(const CONSTPTR(Vector3f) &pt_f, co
 
 	bool isFound; float dt1, dt2;
 
-	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(1, 0, 0), isFound).sdf);
+	sampler.prepare(pt - Vector3i(1, 1, 1), pt + Vector3i(1, 1, 1));
+
+	dt1 = TVoxel::SDF_valueToFloat(sampler.sdfAt(pt + Vector3i(1, 0, 0), isFound));
 	if (!isFound || dt1 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
-	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(-1, 0, 0), isFound).sdf);
+	dt2 = TVoxel::SDF_valueToFloat(sampler.sdfAt(pt + Vector3i(-1, 0, 0), isFound));
 	if (!isFound || dt2 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
 	ddt.x = (dt1 - dt2) * 0.5f;
 
-	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 1, 0), isFound).sdf);
+	dt1 = TVoxel::SDF_valueToFloat(sampler.sdfAt(pt + Vector3i(0, 1, 0), isFound));
 	if (!isFound || dt1 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
-	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, -1, 0), isFound).sdf);
+	dt2 = TVoxel::SDF_valueToFloat(sampler.sdfAt(pt + Vector3i(0, -1, 0), isFound));
 	if (!isFound || dt2 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
 	ddt.y = (dt1 - dt2) * 0.5f;
 
-	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 0, 1), isFound).sdf);
+	dt1 = TVoxel::SDF_valueToFloat(sampler.sdfAt(pt + Vector3i(0, 0, 1), isFound));
 	if (!isFound || dt1 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
-	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 0, -1), isFound).sdf);
+	dt2 = TVoxel::SDF_valueToFloat(sampler.sdfAt(pt + Vector3i(0, 0, -1), isFound));
 	if (!isFound || dt2 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
 	ddt.z = (dt1 - dt2) * 0.5f;
 
@@ -84,12 +90,15 @@ _CPU_AND_GPU_CODE_ inline bool computePerPixelJacobian(THREADPTR(float) *jacobia
 	//typename TIndex::IndexCache cache;
 	//float dt = readFromSDF_float_interpolated(voxelBlocks, index, pt, isFound, cache);
 
-	float dt = readFromSDF_float_uninterpolated(voxelBlocks, index, pt, isFound);
+	// The same sampler serves the value and its gradient, which are read around the same voxel.
+	SDFSampler<TVoxel, typename TIndex::IndexData> sampler(voxelBlocks, index);
+
+	float dt = readFromSDF_float_uninterpolated(sampler, pt, isFound);
 
 	if (dt == 1.0f || !isFound) return false;
 
 
-	dDt = computeDDT<TVoxel, TIndex>(pt, voxelBlocks, index, oneOverVoxelSize, isFound);
+	dDt = computeDDT(pt, sampler, isFound);
 	if (!isFound) return false;
 
 	float expdt = exp(-dt * DTUNE);
@@ -7,8 +7,37 @@
 
 // TODO(andrei): Check out this file for generating smoother meshes (Xinyuan's suggestion).
 
-template<typename T> _CPU_AND_GPU_CODE_ inline int hashIndex(const THREADPTR(T) & blockPos) {
-	return (((uint)blockPos.x * 73856093u) ^ ((uint)blockPos.y * 19349669u) ^ ((uint)blockPos.z * 83492791u)) & (uint)SDF_HASH_MASK;
+template<typename T> _CPU_AND_GPU_CODE_ inline int hashIndex(const THREADPTR(T) & blockPos, int hashMask) {
+	return (((uint)blockPos.x * 73856093u) ^ ((uint)blockPos.y * 19349669u) ^ ((uint)blockPos.z * 83492791u)) & (uint)hashMask;
+}
+
+/// \brief Spreads the three bits of a voxel coordinate inside a block, so that they can be
+///        interleaved with the bits of the other two coordinates.
+_CPU_AND_GPU_CODE_ inline int spreadBlockCoordBits(int v) {
+	return (v & 1) | ((v & 2) << 2) | ((v & 4) << 4);
+}
+
+/// \brief Inverse of spreadBlockCoordBits.
+_CPU_AND_GPU_CODE_ inline int compactBlockCoordBits(int v) {
+	return (v & 1) | ((v >> 2) & 2) | ((v >> 4) & 4);
+}
+
+/// \brief Offset of the voxel at (x, y, z) inside its block, in the layout set by SDF_BLOCK_MORTON_ORDER.
+_CPU_AND_GPU_CODE_ inline int voxelBlockLocalIdx(int x, int y, int z) {
+#if SDF_BLOCK_MORTON_ORDER
+	return spreadBlockCoordBits(x) | (spreadBlockCoordBits(y) << 1) | (spreadBlockCoordBits(z) << 2);
+#else
+	return x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+#endif
+}
+
+/// \brief Position inside its block of the voxel stored at offset locId; see voxelBlockLocalIdx.
+_CPU_AND_GPU_CODE_ inline Vector3i voxelBlockLocalPos(int locId) {
+#if SDF_BLOCK_MORTON_ORDER
+	return Vector3i(compactBlockCoordBits(locId), compactBlockCoordBits(locId >> 1), compactBlockCoordBits(locId >> 2));
+#else
+	return Vector3i(locId & (SDF_BLOCK_SIZE - 1), (locId >> 3) & (SDF_BLOCK_SIZE - 1), locId >> 6);
+#endif
 }
 
 _CPU_AND_GPU_CODE_ inline int pointToVoxelBlockPos(const THREADPTR(Vector3i) & point, THREADPTR(Vector3i) &blockPos) {
@@ -16,9 +45,91 @@ _CPU_AND_GPU_CODE_ inline int pointToVoxelBlockPos(const THREADPTR(Vector3i) & p
 	blockPos.y = ((point.y < 0) ? point.y - SDF_BLOCK_SIZE + 1 : point.y) / SDF_BLOCK_SIZE;
 	blockPos.z = ((point.z < 0) ? point.z - SDF_BLOCK_SIZE + 1 : point.z) / SDF_BLOCK_SIZE;
 
-	//Vector3i locPos = point - blockPos * SDF_BLOCK_SIZE;
-	//return locPos.x + locPos.y * SDF_BLOCK_SIZE + locPos.z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
-	return point.x + (point.y - blockPos.x) * SDF_BLOCK_SIZE + (point.z - blockPos.y) * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE - blockPos.z * SDF_BLOCK_SIZE3;
+	return voxelBlockLocalIdx(point.x - blockPos.x * SDF_BLOCK_SIZE, point.y - blockPos.y * SDF_BLOCK_SIZE,
+		point.z - blockPos.z * SDF_BLOCK_SIZE);
+}
+
+/// \brief Finds the brick and the sector of the occupancy grid of a hash table which count a block;
+///        see ITMVoxelBlockHash::occupancyGridSize.
+_CPU_AND_GPU_CODE_ inline void blockOccupancyIdx(const THREADPTR(Vector3i) &blockPos, THREADPTR(int) &brickIdx,
+	THREADPTR(int) &sectorIdx)
+{
+	const int brickSize = ITMLib::Objects::ITMVoxelBlockHash::occupancyBrickSize;
+	const int sectorSize = ITMLib::Objects::ITMVoxelBlockHash::occupancySectorSize;
+	const int gridSize = ITMLib::Objects::ITMVoxelBlockHash::occupancyGridSize;
+	const int noSectors = gridSize / sectorSize;
+
+	// The grid size is a power of two, so masking wraps the negative coordinates around as well.
+	Vector3i brickPos;
+	brickPos.x = (((blockPos.x < 0) ? blockPos.x - brickSize + 1 : blockPos.x) / brickSize) & (gridSize - 1);
+	brickPos.y = (((blockPos.y < 0) ? blockPos.y - brickSize + 1 : blockPos.y) / brickSize) & (gridSize - 1);
+	brickPos.z = (((blockPos.z < 0) ? blockPos.z - brickSize + 1 : blockPos.z) / brickSize) & (gridSize - 1);
+
+	brickIdx = brickPos.x + (brickPos.y + brickPos.z * gridSize) * gridSize;
+	sectorIdx = brickPos.x / sectorSize + (brickPos.y / sectorSize + brickPos.z / sectorSize * noSectors) * noSectors;
+}
+
+/// \brief If the voxel nearest to a point lies in an empty sector or brick of the occupancy grid of
+///        a hash table, returns how far (in voxels) a ray from the point goes until it leaves that
+///        sector or brick, which has no blocks. Returns 0 otherwise, or if there is no grid.
+_CPU_AND_GPU_CODE_ inline float emptyRegionSkipLength(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex,
+	const THREADPTR(Vector3f) &point, const THREADPTR(Vector3f) &rayDirection)
+{
+	if (voxelIndex->brickOccupancy == NULL) return 0.0f;
+
+	Vector3i blockPos;
+	pointToVoxelBlockPos(Vector3i((int)ROUND(point.x), (int)ROUND(point.y), (int)ROUND(point.z)), blockPos);
+
+	int brickIdx, sectorIdx;
+	blockOccupancyIdx(blockPos, brickIdx, sectorIdx);
+
+	const int brickSize = SDF_BLOCK_SIZE * ITMLib::Objects::ITMVoxelBlockHash::occupancyBrickSize;
+	float cellSize;
+	if (voxelIndex->sectorOccupancy[sectorIdx] == 0) cellSize = (float)(brickSize * ITMLib::Objects::ITMVoxelBlockHash::occupancySectorSize);
+	else if (voxelIndex->brickOccupancy[brickIdx] == 0) cellSize = (float)brickSize;
+	else return 0.0f;
+
+	// The voxels of a cell which starts at voxel a are nearest to the points in [a - 0.5, a + cellSize - 0.5).
+	// The ray leaves the cell where it first crosses one of its faces, and goes a bit further, so
+	// that the next sample is in the next cell. Far from the origin, a tiny step may not get the
+	// sample across the face, so the ray goes at least one voxel, like the steps of castRay.
+	float skipLength = 1e20f;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float p = point[axis] + 0.5f;
+		float cellMin = floor(p / cellSize) * cellSize;
+		if (rayDirection[axis] > 0.0f) skipLength = MIN(skipLength, (cellMin + cellSize - p) / rayDirection[axis]);
+		else if (rayDirection[axis] < 0.0f) skipLength = MIN(skipLength, (cellMin - p) / rayDirection[axis]);
+	}
+	return MAX(skipLength + 0.01f, 1.0f);
+}
+
+/// \brief The other indexes do not keep track of their occupancy.
+template<class TIndexData>
+_CPU_AND_GPU_CODE_ inline float emptyRegionSkipLength(const CONSTPTR(TIndexData) *voxelIndex, const THREADPTR(Vector3f) &point,
+	const THREADPTR(Vector3f) &rayDirection)
+{
+	return 0.0f;
+}
+
+/// \brief Looks up a block in the previous table of a growing hash table.
+/// \return The block's entry in the previous table, or -1 if it is not there, e.g., because it has
+///         already been migrated, or because the table is not growing.
+_CPU_AND_GPU_CODE_ inline int findBlockInOldTable(
+		const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex,
+		const THREADPTR(Vector3i) &blockPos
+) {
+	if (voxelIndex->oldEntries == NULL) return -1;
+
+	int idx = hashIndex(blockPos, voxelIndex->oldHashMask);
+
+	while (true) {
+		const CONSTPTR(ITMHashEntry) &hashEntry = voxelIndex->oldEntries[idx];
+		if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= 0) return idx;
+		if (hashEntry.offset < 1) return -1;
+
+		idx = voxelIndex->oldBucketNum + hashEntry.offset - 1;
+	}
 }
 
 _CPU_AND_GPU_CODE_ inline int findVoxel(
@@ -37,11 +148,11 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(
 		return cache.blockPtr + linearIdx;
 	}
 
-	int hashIdx = hashIndex(blockPos);
+	int hashIdx = hashIndex(blockPos, voxelIndex->hashMask);
 
 	while (true) 
 	{
-		ITMHashEntry hashEntry = voxelIndex[hashIdx];
+		ITMHashEntry hashEntry = voxelIndex->entries[hashIdx];
 
 		if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= 0)
 		{
@@ -52,22 +163,34 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(
 
 		// Advance to the next element in the bucket, if it exists.
 		if (hashEntry.offset < 1) break;
-		hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+		hashIdx = voxelIndex->bucketNum + hashEntry.offset - 1;
+	}
+
+	// The block may not have been migrated yet, if the table is growing.
+	int oldIdx = findBlockInOldTable(voxelIndex, blockPos);
+	if (oldIdx >= 0)
+	{
+		isFound = true;
+		cache.blockPos = blockPos; cache.blockPtr = voxelIndex->oldEntries[oldIdx].ptr * SDF_BLOCK_SIZE3;
+		return cache.blockPtr + linearIdx;
 	}
 
 	isFound = false;
 	return -1;
 }
 
+/// \brief Returns the index of a block's entry in the hash table. While the table grows, blocks
+///        which have not been migrated yet are not found, since the index would refer to the
+///        previous table; see findBlockInOldTable.
 _CPU_AND_GPU_CODE_ inline int findBlock(
 		const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *hashMap,
 		const THREADPTR(Vector3i) &blockPos,
         THREADPTR(bool) &isFound
 ) {
-	int idx = hashIndex(blockPos);
+	int idx = hashIndex(blockPos, hashMap->hashMask);
 
 	while (true) {
-		ITMHashEntry hashEntry = hashMap[idx];
+		ITMHashEntry hashEntry = hashMap->entries[idx];
 		if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= 0)
 		{
 			isFound = true;
@@ -78,7 +201,7 @@ _CPU_AND_GPU_CODE_ inline int findBlock(
 			break;
 		}
 
-		idx = static_cast<int>(SDF_BUCKET_NUM) + hashEntry.offset - 1;
+		idx = hashMap->bucketNum + hashEntry.offset - 1;
 	}
 
 	return -1;
@@ -103,11 +226,11 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(
 	outPrevHashIdx = -1;
 
 	// Look for the voxel in the excess list, by walking it until the end of the "chain".
-	int hashIdx = hashIndex(blockPos);
+	int hashIdx = hashIndex(blockPos, voxelIndex->hashMask);
 
 	while (true)
 	{
-		ITMHashEntry hashEntry = voxelIndex[hashIdx];
+		ITMHashEntry hashEntry = voxelIndex->entries[hashIdx];
 
 		if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= 0)
 		{
@@ -122,7 +245,7 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(
 		}
 
 		outPrevHashIdx = hashIdx;
-		hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+		hashIdx = voxelIndex->bucketNum + hashEntry.offset - 1;
 	}
 
 	outHashIdx = -1;
@@ -149,6 +272,12 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMVoxel
 	return findVoxel(voxelIndex, point, isFound, cache);
 }
 
+/// \brief Whether the hash entry is in the excess list, rather than in the ordered part of the table.
+_CPU_AND_GPU_CODE_ inline bool isExcessEntry(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex, int hashIdx)
+{
+	return hashIdx >= voxelIndex->bucketNum;
+}
+
 _CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexData) *voxelIndex, const THREADPTR(Vector3i) & point_orig,
 	THREADPTR(bool) &isFound)
 {
@@ -173,6 +302,125 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMPlain
 	return findVoxel(voxelIndex, point_orig, isFound);
 }
 
+/// \brief Like the hashed findVoxel, which also returns the entry of the block. The whole volume
+///        is a single entry.
+_CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) &point, THREADPTR(bool) &isFound, THREADPTR(int) &outBlockIdx, THREADPTR(int) &outPrevBlockIdx)
+{
+	int voxelIdx = findVoxel(voxelIndex, point, isFound);
+	outBlockIdx = isFound ? 0 : -1;
+	outPrevBlockIdx = -1;
+	return voxelIdx;
+}
+
+/// \brief A plain voxel array has no excess list.
+_CPU_AND_GPU_CODE_ inline bool isExcessEntry(const CONSTPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexData) *voxelIndex, int blockIdx)
+{
+	return false;
+}
+
+/// \brief Looks up a block in an open-addressing hash table.
+///
+/// Probes the slots following the hashed one (linear probing), SDF_OPEN_HASH_GROUP_SIZE slots at
+/// a time, until either the block or an empty slot is found. Since entries are never removed, the
+/// block cannot be stored past the first empty slot on its probe sequence.
+///
+/// \param outFreeSlot If the block is not in the table, this is set to the first empty slot on its
+///                    probe sequence, i.e., where it would have to be inserted, or to -1 if the
+///                    table is full. Otherwise, it is set to -1.
+/// \return The index of the block's entry, or -1 if it is not in the table.
+_CPU_AND_GPU_CODE_ inline int findBlockOrFreeSlot(
+		const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+		const THREADPTR(Vector3i) &blockPos,
+		THREADPTR(int) &outFreeSlot
+) {
+	int slotMask = voxelIndex->slotMask;
+	int groupStart = hashIndex(blockPos, slotMask);
+	int noGroups = voxelIndex->slotNum / SDF_OPEN_HASH_GROUP_SIZE;
+
+	for (int probe = 0; probe < noGroups; probe++)
+	{
+		for (int i = 0; i < SDF_OPEN_HASH_GROUP_SIZE; i++)
+		{
+			int slotIdx = (groupStart + i) & slotMask;
+			const CONSTPTR(ITMHashEntry) &entry = voxelIndex->entries[slotIdx];
+
+			if (entry.ptr < -1) { outFreeSlot = slotIdx; return -1; }
+			if (IS_EQUAL3(entry.pos, blockPos)) { outFreeSlot = -1; return slotIdx; }
+		}
+
+		groupStart = (groupStart + SDF_OPEN_HASH_GROUP_SIZE) & slotMask;
+	}
+
+	outFreeSlot = -1;
+	return -1;
+}
+
+_CPU_AND_GPU_CODE_ inline int findBlock(
+		const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+		const THREADPTR(Vector3i) &blockPos,
+		THREADPTR(bool) &isFound
+) {
+	int freeSlot;
+	int idx = findBlockOrFreeSlot(voxelIndex, blockPos, freeSlot);
+
+	isFound = (idx >= 0 && voxelIndex->entries[idx].ptr >= 0);
+	return isFound ? idx : -1;
+}
+
+_CPU_AND_GPU_CODE_ inline int findVoxel(
+		const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+		const THREADPTR(Vector3i) &point,
+		THREADPTR(bool) &isFound,
+		THREADPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexCache) &cache
+) {
+	Vector3i blockPos;
+	int linearIdx = pointToVoxelBlockPos(point, blockPos);
+
+	if IS_EQUAL3(blockPos, cache.blockPos)
+	{
+		isFound = true;
+		return cache.blockPtr + linearIdx;
+	}
+
+	int hashIdx = findBlock(voxelIndex, blockPos, isFound);
+	if (!isFound) return -1;
+
+	cache.blockPos = blockPos; cache.blockPtr = voxelIndex->entries[hashIdx].ptr * SDF_BLOCK_SIZE3;
+	return cache.blockPtr + linearIdx;
+}
+
+_CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex, Vector3i point, THREADPTR(bool) &isFound)
+{
+	ITMLib::Objects::ITMVoxelBlockOpenHash::IndexCache cache;
+	return findVoxel(voxelIndex, point, isFound, cache);
+}
+
+/// \brief Same as for the chained hash table. Since the open table has no chains, there is never a
+///        previous entry.
+_CPU_AND_GPU_CODE_ inline int findVoxel(
+		const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+		const THREADPTR(Vector3i) &point,
+		THREADPTR(bool) &isFound,
+		THREADPTR(int) &outHashIdx,
+		THREADPTR(int) &outPrevHashIdx
+) {
+	Vector3i blockPos;
+	int linearIdx = pointToVoxelBlockPos(point, blockPos);
+
+	outPrevHashIdx = -1;
+	outHashIdx = findBlock(voxelIndex, blockPos, isFound);
+	if (!isFound) return -1;
+
+	return voxelIndex->entries[outHashIdx].ptr * SDF_BLOCK_SIZE3 + linearIdx;
+}
+
+/// \brief The open hash table has no excess list.
+_CPU_AND_GPU_CODE_ inline bool isExcessEntry(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex, int hashIdx)
+{
+	return false;
+}
+
 template<class TVoxel>
 _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex,
 	const THREADPTR(Vector3i) & point, THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexCache) & cache)
@@ -188,11 +436,11 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 		return voxelData[cache.blockPtr + linearIdx];
 	}
 
-	int hashIdx = hashIndex(blockPos);
+	int hashIdx = hashIndex(blockPos, voxelIndex->hashMask);
 
 	while (true)
 	{
-		ITMHashEntry hashEntry = voxelIndex[hashIdx];
+		ITMHashEntry hashEntry = voxelIndex->entries[hashIdx];
 
 		if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= 0)
 		{
@@ -204,7 +452,16 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 		// Walk the excess list, if necessary, until we find the right block.
 		if (hashEntry.offset < 1) break;
 
-		hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+		hashIdx = voxelIndex->bucketNum + hashEntry.offset - 1;
+	}
+
+	// The block may not have been migrated yet, if the table is growing.
+	int oldIdx = findBlockInOldTable(voxelIndex, blockPos);
+	if (oldIdx >= 0)
+	{
+		isFound = true;
+		cache.blockPos = blockPos; cache.blockPtr = voxelIndex->oldEntries[oldIdx].ptr * SDF_BLOCK_SIZE3;
+		return voxelData[cache.blockPtr + linearIdx];
 	}
 
 	isFound = false;
@@ -234,6 +491,178 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 	return readVoxel(voxelData, voxelIndex, point_orig, isFound);
 }
 
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) & point, THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexCache) & cache)
+{
+	int voxelAddress = findVoxel(voxelIndex, point, isFound, cache);
+	return isFound ? voxelData[voxelAddress] : TVoxel();
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+	Vector3i point, THREADPTR(bool) &isFound)
+{
+	ITMLib::Objects::ITMVoxelBlockOpenHash::IndexCache cache;
+	return readVoxel(voxelData, voxelIndex, point, isFound, cache);
+}
+
+/// \brief Reads voxels from a hashed volume for interpolation and gradients. Remembers the blocks of
+///        a 2x2x2 neighbourhood, so that the corners of the cells it is asked for only need hash
+///        lookups when the cells leave the neighbourhood, even at block borders, where the single
+///        entry IndexCache misses all the time. The blocks are looked up when a cell first needs
+///        them (see prepare), and the reads themselves do not branch: voxels of unallocated blocks
+///        read as TVoxel().
+template<class TVoxel, class TIndexData>
+struct SDFSampler
+{
+	const CONSTPTR(TVoxel) *voxelData;
+	const CONSTPTR(TIndexData) *voxelIndex;
+	/// Lowest voxel of the neighbourhood, which spans 2 * SDF_BLOCK_SIZE voxels along every axis.
+	Vector3i anchor;
+	/// Bit i is set once block i of the neighbourhood, at anchor + SDF_BLOCK_SIZE * (i & 1,
+	/// (i >> 1) & 1, i >> 2), has been looked up.
+	int resolvedBlocks;
+	/// Offset of the blocks in voxelData, and whether they are allocated at all. The offset of a
+	/// missing block is 0, so that reading from it is harmless.
+	int blockPtrs[8];
+	float blockFound[8];
+
+	_CPU_AND_GPU_CODE_ SDFSampler(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(TIndexData) *voxelIndex)
+		: voxelData(voxelData), voxelIndex(voxelIndex), anchor(-0x40000000), resolvedBlocks(0) {}
+
+	/// \brief Makes sure that the voxels between minPoint and maxPoint, which may be at most
+	///        SDF_BLOCK_SIZE voxels apart along every axis, can be read.
+	_CPU_AND_GPU_CODE_ void prepare(const THREADPTR(Vector3i) &minPoint, const THREADPTR(Vector3i) &maxPoint)
+	{
+		Vector3i minLocal = minPoint - anchor, maxLocal = maxPoint - anchor;
+		if (minLocal.x < 0 || minLocal.y < 0 || minLocal.z < 0 ||
+			maxLocal.x >= 2 * SDF_BLOCK_SIZE || maxLocal.y >= 2 * SDF_BLOCK_SIZE || maxLocal.z >= 2 * SDF_BLOCK_SIZE)
+		{
+			Vector3i blockPos;
+			pointToVoxelBlockPos(minPoint, blockPos);
+			anchor = blockPos * SDF_BLOCK_SIZE;
+			resolvedBlocks = 0;
+			minLocal = minPoint - anchor; maxLocal = maxPoint - anchor;
+		}
+
+		for (int bz = minLocal.z / SDF_BLOCK_SIZE; bz <= maxLocal.z / SDF_BLOCK_SIZE; bz++)
+		for (int by = minLocal.y / SDF_BLOCK_SIZE; by <= maxLocal.y / SDF_BLOCK_SIZE; by++)
+		for (int bx = minLocal.x / SDF_BLOCK_SIZE; bx <= maxLocal.x / SDF_BLOCK_SIZE; bx++)
+		{
+			int blockIdx = bx | (by << 1) | (bz << 2);
+			if (resolvedBlocks & (1 << blockIdx)) continue;
+
+			bool isFound = false;
+			int voxelIdx = findVoxel(voxelIndex, anchor + Vector3i(bx, by, bz) * SDF_BLOCK_SIZE, isFound);
+			blockPtrs[blockIdx] = isFound ? voxelIdx : 0;
+			blockFound[blockIdx] = isFound ? 1.0f : 0.0f;
+			resolvedBlocks |= 1 << blockIdx;
+		}
+	}
+
+	/// \brief The stored SDF value of a voxel prepared for, as a float (not normalised).
+	_CPU_AND_GPU_CODE_ float sdfAt(const THREADPTR(Vector3i) &point, THREADPTR(bool) &isFound) const
+	{
+		Vector3i local = point - anchor;
+		int blockIdx = (local.x / SDF_BLOCK_SIZE) | ((local.y / SDF_BLOCK_SIZE) << 1) | ((local.z / SDF_BLOCK_SIZE) << 2);
+		int linearIdx = voxelBlockLocalIdx(local.x % SDF_BLOCK_SIZE, local.y % SDF_BLOCK_SIZE, local.z % SDF_BLOCK_SIZE);
+
+		float found = blockFound[blockIdx];
+		float value = voxelData[blockPtrs[blockIdx] + linearIdx].sdf;
+		isFound = found > 0.0f;
+		return found * value + (1.0f - found) * (float)TVoxel::SDF_initialValue();
+	}
+
+	_CPU_AND_GPU_CODE_ float sdfAt(const THREADPTR(Vector3i) &point) const
+	{
+		bool isFound;
+		return sdfAt(point, isFound);
+	}
+
+	/// \brief A whole voxel prepared for, or TVoxel() if its block is not allocated.
+	_CPU_AND_GPU_CODE_ TVoxel voxelAt(const THREADPTR(Vector3i) &point) const
+	{
+		Vector3i local = point - anchor;
+		int blockIdx = (local.x / SDF_BLOCK_SIZE) | ((local.y / SDF_BLOCK_SIZE) << 1) | ((local.z / SDF_BLOCK_SIZE) << 2);
+		int linearIdx = voxelBlockLocalIdx(local.x % SDF_BLOCK_SIZE, local.y % SDF_BLOCK_SIZE, local.z % SDF_BLOCK_SIZE);
+
+		return blockFound[blockIdx] > 0.0f ? voxelData[blockPtrs[blockIdx] + linearIdx] : TVoxel();
+	}
+};
+
+/// \brief The plain voxel array has no blocks, so its voxels are read one by one.
+template<class TVoxel>
+struct SDFSampler<TVoxel, ITMLib::Objects::ITMPlainVoxelArray::IndexData>
+{
+	const CONSTPTR(TVoxel) *voxelData;
+	const CONSTPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexData) *voxelIndex;
+
+	_CPU_AND_GPU_CODE_ SDFSampler(const CONSTPTR(TVoxel) *voxelData,
+		const CONSTPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexData) *voxelIndex)
+		: voxelData(voxelData), voxelIndex(voxelIndex) {}
+
+	_CPU_AND_GPU_CODE_ void prepare(const THREADPTR(Vector3i) &minPoint, const THREADPTR(Vector3i) &maxPoint) {}
+
+	_CPU_AND_GPU_CODE_ float sdfAt(const THREADPTR(Vector3i) &point, THREADPTR(bool) &isFound) const
+	{
+		int voxelIdx = findVoxel(voxelIndex, point, isFound);
+		return isFound ? (float)voxelData[voxelIdx].sdf : (float)TVoxel::SDF_initialValue();
+	}
+
+	_CPU_AND_GPU_CODE_ float sdfAt(const THREADPTR(Vector3i) &point) const
+	{
+		bool isFound;
+		return sdfAt(point, isFound);
+	}
+
+	_CPU_AND_GPU_CODE_ TVoxel voxelAt(const THREADPTR(Vector3i) &point) const
+	{
+		bool isFound;
+		int voxelIdx = findVoxel(voxelIndex, point, isFound);
+		return isFound ? voxelData[voxelIdx] : TVoxel();
+	}
+};
+
+/// \brief Reads the SDF value of the voxel nearest to a point.
+template<class TVoxel, class TIndexData>
+_CPU_AND_GPU_CODE_ inline float readFromSDF_float_uninterpolated(SDFSampler<TVoxel, TIndexData> &sampler,
+	const THREADPTR(Vector3f) &point, THREADPTR(bool) &isFound)
+{
+	Vector3i pos((int)ROUND(point.x), (int)ROUND(point.y), (int)ROUND(point.z));
+	sampler.prepare(pos, pos);
+	return TVoxel::SDF_valueToFloat(sampler.sdfAt(pos, isFound));
+}
+
+/// \brief Reads the trilinearly interpolated SDF value at a point.
+template<class TVoxel, class TIndexData>
+_CPU_AND_GPU_CODE_ inline float readFromSDF_float_interpolated(SDFSampler<TVoxel, TIndexData> &sampler,
+	const THREADPTR(Vector3f) &point, THREADPTR(bool) &isFound)
+{
+	float res1, res2, v1, v2;
+	Vector3f coeff; Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
+	sampler.prepare(pos, pos + Vector3i(1, 1, 1));
+
+	v1 = sampler.sdfAt(pos + Vector3i(0, 0, 0));
+	v2 = sampler.sdfAt(pos + Vector3i(1, 0, 0));
+	res1 = (1.0f - coeff.x) * v1 + coeff.x * v2;
+
+	v1 = sampler.sdfAt(pos + Vector3i(0, 1, 0));
+	v2 = sampler.sdfAt(pos + Vector3i(1, 1, 0));
+	res1 = (1.0f - coeff.y) * res1 + coeff.y * ((1.0f - coeff.x) * v1 + coeff.x * v2);
+
+	v1 = sampler.sdfAt(pos + Vector3i(0, 0, 1));
+	v2 = sampler.sdfAt(pos + Vector3i(1, 0, 1));
+	res2 = (1.0f - coeff.x) * v1 + coeff.x * v2;
+
+	v1 = sampler.sdfAt(pos + Vector3i(0, 1, 1));
+	v2 = sampler.sdfAt(pos + Vector3i(1, 1, 1));
+	res2 = (1.0f - coeff.y) * res2 + coeff.y * ((1.0f - coeff.x) * v1 + coeff.x * v2);
+
+	isFound = true;
+	return TVoxel::SDF_valueToFloat((1.0f - coeff.z) * res1 + coeff.z * res2);
+}
+
 template<class TVoxel, class TIndex>
 _CPU_AND_GPU_CODE_ inline float readFromSDF_float_uninterpolated(const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(TIndex) *voxelIndex, Vector3f point, THREADPTR(bool) &isFound)
@@ -280,39 +709,37 @@ _CPU_AND_GPU_CODE_ inline float readFromSDF_float_interpolated(const CONSTPTR(TV
 /// \brief Reads color data from the SDF volume, returning it as a 3-vector.
 template<class TVoxel, class TIndex>
 _CPU_AND_GPU_CODE_ inline Vector3f readFromSDF_color4u_interpolated_noalpha(
-		const CONSTPTR(TVoxel) *voxelData,
-		const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
-		const THREADPTR(Vector3f) &point,
-		THREADPTR(typename TIndex::IndexCache) &cache
+		SDFSampler<TVoxel, typename TIndex::IndexData> &sampler,
+		const THREADPTR(Vector3f) &point
 ) {
 	TVoxel resn;
 	Vector3f ret = 0.0f;
-	bool isFound;
 	Vector3f coeff;
 	Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
+	sampler.prepare(pos, pos + Vector3i(1, 1, 1));
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), isFound, cache);
+	resn = sampler.voxelAt(pos + Vector3i(0, 0, 0));
 	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), isFound, cache);
+	resn = sampler.voxelAt(pos + Vector3i(1, 0, 0));
 	ret += (coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), isFound, cache);
+	resn = sampler.voxelAt(pos + Vector3i(0, 1, 0));
 	ret += (1.0f - coeff.x) * (coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), isFound, cache);
+	resn = sampler.voxelAt(pos + Vector3i(1, 1, 0));
 	ret += (coeff.x) * (coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), isFound, cache);
+	resn = sampler.voxelAt(pos + Vector3i(0, 0, 1));
 	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * coeff.z * resn.clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), isFound, cache);
+	resn = sampler.voxelAt(pos + Vector3i(1, 0, 1));
 	ret += (coeff.x) * (1.0f - coeff.y) * coeff.z * resn.clr.toFloat();;
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), isFound, cache);
+	resn = sampler.voxelAt(pos + Vector3i(0, 1, 1));
 	ret += (1.0f - coeff.x) * (coeff.y) * coeff.z * resn.clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), isFound, cache);
+	resn = sampler.voxelAt(pos + Vector3i(1, 1, 1));
 	ret += (coeff.x) * (coeff.y) * coeff.z * resn.clr.toFloat();
 
 	return ret / 255.0f;
@@ -320,38 +747,36 @@ _CPU_AND_GPU_CODE_ inline Vector3f readFromSDF_color4u_interpolated_noalpha(
 
 /// \brief Returns color data from the SDF volume as a 4-vector also containing (dummy) alpha info.
 template<class TVoxel, class TIndex>
-_CPU_AND_GPU_CODE_ inline Vector4f readFromSDF_color4u_interpolated(const CONSTPTR(TVoxel) *voxelData,
-	const CONSTPTR(typename TIndex::IndexData) *voxelIndex, const THREADPTR(Vector3f) & point,
-	THREADPTR(typename TIndex::IndexCache) & cache)
+_CPU_AND_GPU_CODE_ inline Vector4f readFromSDF_color4u_interpolated(
+	SDFSampler<TVoxel, typename TIndex::IndexData> &sampler, const THREADPTR(Vector3f) & point)
 {
-	Vector3f ret = readFromSDF_color4u_interpolated_noalpha<TVoxel, TIndex>(
-		voxelData, voxelIndex, point, cache
-	);
+	Vector3f ret = readFromSDF_color4u_interpolated_noalpha<TVoxel, TIndex>(sampler, point);
 
 	Vector4f ret4;
 	ret4.x = ret.x; ret4.y = ret.y; ret4.z = ret.z; ret4.w = 1.0f;
 	return ret4;
 }
 
-template<class TVoxel, class TIndex>
-_CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(TIndex) *voxelIndex, const THREADPTR(Vector3f) &point)
+/// \brief The SDF gradient at a point, from central differences of trilinearly interpolated values.
+template<class TVoxel, class TIndexData>
+_CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(SDFSampler<TVoxel, TIndexData> &sampler,
+	const THREADPTR(Vector3f) &point)
 {
-	bool isFound;
-
 	Vector3f ret;
 	Vector3f coeff; Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
+	sampler.prepare(pos - Vector3i(1, 1, 1), pos + Vector3i(2, 2, 2));
 	Vector3f ncoeff(1.0f - coeff.x, 1.0f - coeff.y, 1.0f - coeff.z);
 
 	// all 8 values are going to be reused several times
 	Vector4f front, back;
-	front.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), isFound).sdf;
-	front.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), isFound).sdf;
-	front.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), isFound).sdf;
-	front.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), isFound).sdf;
-	back.x  = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), isFound).sdf;
-	back.y  = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), isFound).sdf;
-	back.z  = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), isFound).sdf;
-	back.w  = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), isFound).sdf;
+	front.x = sampler.sdfAt(pos + Vector3i(0, 0, 0));
+	front.y = sampler.sdfAt(pos + Vector3i(1, 0, 0));
+	front.z = sampler.sdfAt(pos + Vector3i(0, 1, 0));
+	front.w = sampler.sdfAt(pos + Vector3i(1, 1, 0));
+	back.x  = sampler.sdfAt(pos + Vector3i(0, 0, 1));
+	back.y  = sampler.sdfAt(pos + Vector3i(1, 0, 1));
+	back.z  = sampler.sdfAt(pos + Vector3i(0, 1, 1));
+	back.w  = sampler.sdfAt(pos + Vector3i(1, 1, 1));
 
 	Vector4f tmp;
 	float p1, p2, v1;
@@ -360,10 +785,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     front.z *  coeff.y * ncoeff.z +
 	     back.x  * ncoeff.y *  coeff.z +
 	     back.z  *  coeff.y *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 0, 0), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 1, 0), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 0, 1), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 1, 1), isFound).sdf;
+	tmp.x = sampler.sdfAt(pos + Vector3i(-1, 0, 0));
+	tmp.y = sampler.sdfAt(pos + Vector3i(-1, 1, 0));
+	tmp.z = sampler.sdfAt(pos + Vector3i(-1, 0, 1));
+	tmp.w = sampler.sdfAt(pos + Vector3i(-1, 1, 1));
 	p2 = tmp.x * ncoeff.y * ncoeff.z +
 	     tmp.y *  coeff.y * ncoeff.z +
 	     tmp.z * ncoeff.y *  coeff.z +
@@ -374,10 +799,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     front.w *  coeff.y * ncoeff.z +
 	     back.y  * ncoeff.y *  coeff.z +
 	     back.w  *  coeff.y *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 0, 0), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 1, 0), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 0, 1), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 1, 1), isFound).sdf;
+	tmp.x = sampler.sdfAt(pos + Vector3i(2, 0, 0));
+	tmp.y = sampler.sdfAt(pos + Vector3i(2, 1, 0));
+	tmp.z = sampler.sdfAt(pos + Vector3i(2, 0, 1));
+	tmp.w = sampler.sdfAt(pos + Vector3i(2, 1, 1));
 	p2 = tmp.x * ncoeff.y * ncoeff.z +
 	     tmp.y *  coeff.y * ncoeff.z +
 	     tmp.z * ncoeff.y *  coeff.z +
@@ -390,10 +815,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     front.y *  coeff.x * ncoeff.z +
 	     back.x  * ncoeff.x *  coeff.z +
 	     back.y  *  coeff.x *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, -1, 0), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, -1, 0), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, -1, 1), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, -1, 1), isFound).sdf;
+	tmp.x = sampler.sdfAt(pos + Vector3i(0, -1, 0));
+	tmp.y = sampler.sdfAt(pos + Vector3i(1, -1, 0));
+	tmp.z = sampler.sdfAt(pos + Vector3i(0, -1, 1));
+	tmp.w = sampler.sdfAt(pos + Vector3i(1, -1, 1));
 	p2 = tmp.x * ncoeff.x * ncoeff.z +
 	     tmp.y *  coeff.x * ncoeff.z +
 	     tmp.z * ncoeff.x *  coeff.z +
@@ -404,10 +829,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     front.w *  coeff.x * ncoeff.z +
 	     back.z  * ncoeff.x *  coeff.z +
 	     back.w  *  coeff.x *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 2, 0), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 2, 0), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 2, 1), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 2, 1), isFound).sdf;
+	tmp.x = sampler.sdfAt(pos + Vector3i(0, 2, 0));
+	tmp.y = sampler.sdfAt(pos + Vector3i(1, 2, 0));
+	tmp.z = sampler.sdfAt(pos + Vector3i(0, 2, 1));
+	tmp.w = sampler.sdfAt(pos + Vector3i(1, 2, 1));
 	p2 = tmp.x * ncoeff.x * ncoeff.z +
 	     tmp.y *  coeff.x * ncoeff.z +
 	     tmp.z * ncoeff.x *  coeff.z +
@@ -420,10 +845,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     front.y *  coeff.x * ncoeff.y +
 	     front.z * ncoeff.x *  coeff.y +
 	     front.w *  coeff.x *  coeff.y;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, -1), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, -1), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, -1), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, -1), isFound).sdf;
+	tmp.x = sampler.sdfAt(pos + Vector3i(0, 0, -1));
+	tmp.y = sampler.sdfAt(pos + Vector3i(1, 0, -1));
+	tmp.z = sampler.sdfAt(pos + Vector3i(0, 1, -1));
+	tmp.w = sampler.sdfAt(pos + Vector3i(1, 1, -1));
 	p2 = tmp.x * ncoeff.x * ncoeff.y +
 	     tmp.y *  coeff.x * ncoeff.y +
 	     tmp.z * ncoeff.x *  coeff.y +
@@ -434,10 +859,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     back.y *  coeff.x * ncoeff.y +
 	     back.z * ncoeff.x *  coeff.y +
 	     back.w *  coeff.x *  coeff.y;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 2), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 2), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 2), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 2), isFound).sdf;
+	tmp.x = sampler.sdfAt(pos + Vector3i(0, 0, 2));
+	tmp.y = sampler.sdfAt(pos + Vector3i(1, 0, 2));
+	tmp.z = sampler.sdfAt(pos + Vector3i(0, 1, 2));
+	tmp.w = sampler.sdfAt(pos + Vector3i(1, 1, 2));
 	p2 = tmp.x * ncoeff.x * ncoeff.y +
 	     tmp.y *  coeff.x * ncoeff.y +
 	     tmp.z * ncoeff.x *  coeff.y +
@@ -448,6 +873,14 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	return ret;
 }
 
+template<class TVoxel, class TIndexData>
+_CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(TIndexData) *voxelIndex,
+	const THREADPTR(Vector3f) &point)
+{
+	SDFSampler<TVoxel, TIndexData> sampler(voxelData, voxelIndex);
+	return computeSingleNormalFromSDF(sampler, point);
+}
+
 template<bool hasColor,class TVoxel,class TIndex> struct VoxelColorReader;
 
 template<class TVoxel, class TIndex>
@@ -476,8 +909,8 @@ struct VoxelColorReader<true,TVoxel,TIndex> {
 		const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
 		const THREADPTR(Vector3f) & point
 	) {
-		typename TIndex::IndexCache cache;
-		return readFromSDF_color4u_interpolated_noalpha<TVoxel,TIndex>(voxelData, voxelIndex, point, cache);
+		SDFSampler<TVoxel, typename TIndex::IndexData> sampler(voxelData, voxelIndex);
+		return readFromSDF_color4u_interpolated_noalpha<TVoxel,TIndex>(sampler, point);
   }
 
 	_CPU_AND_GPU_CODE_ static Vector4f interpolate(
@@ -485,7 +918,7 @@ struct VoxelColorReader<true,TVoxel,TIndex> {
 		const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
 		const THREADPTR(Vector3f) & point
 	) {
-		typename TIndex::IndexCache cache;
-		return readFromSDF_color4u_interpolated<TVoxel,TIndex>(voxelData, voxelIndex, point, cache);
+		SDFSampler<TVoxel, typename TIndex::IndexData> sampler(voxelData, voxelIndex);
+		return readFromSDF_color4u_interpolated<TVoxel,TIndex>(sampler, point);
 	}
 };
@@ -11,6 +11,21 @@
 const int BUCKET_UNLOCKED = 0;
 const int BUCKET_LOCKED = 1;
 
+/// \brief Atomically sets the lock of a hash bucket to `state`, returning its previous state.
+_CPU_AND_GPU_CODE_ inline int exchangeBucketLock(DEVICEPTR(int) *locks, int key, int state)
+{
+#if defined(__CUDACC__) && defined(__CUDA_ARCH__)
+	return atomicExch(&locks[key], state);
+#else
+	int old;
+#ifdef WITH_OPENMP
+	#pragma omp atomic capture
+#endif
+	{ old = locks[key]; locks[key] = state; }
+	return old;
+#endif
+}
+
 template<class TVoxel>
 _CPU_AND_GPU_CODE_ inline float computeUpdatedVoxelDepthInfo(
 		DEVICEPTR(TVoxel) &voxel,
@@ -127,6 +142,27 @@ _CPU_AND_GPU_CODE_ inline void computeUpdatedVoxelColorInfo(DEVICEPTR(TVoxel) &v
 	voxel.w_color = (uchar)newW;
 }
 
+/// \brief Dispatches to 'computeUpdatedVoxelColorInfo' only for voxel types which store colour.
+template<bool hasColor, class TVoxel> struct ComputeUpdatedVoxelColorInfo;
+
+template<class TVoxel>
+struct ComputeUpdatedVoxelColorInfo<false, TVoxel> {
+	_CPU_AND_GPU_CODE_ static void compute(DEVICEPTR(TVoxel) &voxel, const THREADPTR(Vector4f) &pt_model,
+		const CONSTPTR(Matrix4f) &M_rgb, const CONSTPTR(Vector4f) &projParams_rgb, float mu, uchar maxW, float eta,
+		const CONSTPTR(Vector4u) *rgb, const CONSTPTR(Vector2i) &imgSize)
+	{}
+};
+
+template<class TVoxel>
+struct ComputeUpdatedVoxelColorInfo<true, TVoxel> {
+	_CPU_AND_GPU_CODE_ static void compute(DEVICEPTR(TVoxel) &voxel, const THREADPTR(Vector4f) &pt_model,
+		const CONSTPTR(Matrix4f) &M_rgb, const CONSTPTR(Vector4f) &projParams_rgb, float mu, uchar maxW, float eta,
+		const CONSTPTR(Vector4u) *rgb, const CONSTPTR(Vector2i) &imgSize)
+	{
+		computeUpdatedVoxelColorInfo(voxel, pt_model, M_rgb, projParams_rgb, mu, maxW, eta, rgb, imgSize);
+	}
+};
+
 template<bool hasColor, class TVoxel> struct ComputeUpdatedVoxelInfo;
 
 template<class TVoxel>
@@ -170,36 +206,33 @@ struct ComputeUpdatedVoxelInfo<true, TVoxel> {
 	}
 };
 
-// TODO-LOW(andrei): Change back to hybrid code. _CPU_AND_GPU_CODE_
-// Note that you'd then need to add CPU-specific locking since the code can still run in parallel
-// on the CPU, but there's no fast CUDA atomics there.
-__device__
-inline void buildHashAllocAndVisibleTypePP(
-		DEVICEPTR(uchar) *entriesAllocType,
-		DEVICEPTR(uchar) *entriesVisibleType,
+/// \brief Computes the part of the ray through a depth pixel which lies within mu of the
+///        measurement, in voxel block coordinates.
+/// \return False if the pixel has no valid measurement within the view frustum.
+_CPU_AND_GPU_CODE_ inline bool computeAllocationRay(
+		THREADPTR(Vector3f) &point,
+		THREADPTR(Vector3f) &direction,
+		THREADPTR(int) &noSteps,
 		int x,
 		int y,
-		DEVICEPTR(Vector4s) *blockCoords,
 		const CONSTPTR(float) *depth,
 		Matrix4f invM_d,
 		Vector4f projParams_d,
 		float mu,
 		Vector2i imgSize,
 		float oneOverVoxelSize,
-		const CONSTPTR(ITMHashEntry) *hashTable,
 		float viewFrustum_min,
-		float viewFrustum_max,
-		int *locks
+		float viewFrustum_max
 ) {
-	float depth_measure; unsigned int hashIdx; int noSteps;
-	Vector3f pt_camera_f, point_e, point, direction; Vector3s blockPos;
+	float depth_measure;
+	Vector3f pt_camera_f, point_e;
 
 	depth_measure = depth[x + y * imgSize.x];
 
 	if (depth_measure <= 0 || (depth_measure - mu) < 0 ||
 		(depth_measure - mu) < viewFrustum_min || (depth_measure + mu) > viewFrustum_max
 	) {
-		return;
+		return false;
 	}
 
 	// This triangulates the point's position from x, y, and depth.
@@ -233,6 +266,37 @@ inline void buildHashAllocAndVisibleTypePP(
 	noSteps = (int)ceil(2.0f*norm);
 
 	direction /= (float)(noSteps - 1);
+	return true;
+}
+
+/// \brief Walks the ray through a single depth pixel and flags the blocks around the measurement
+///        for allocation. Buckets are locked while being inspected, so this can run in parallel
+///        both on the GPU and in the OpenMP CPU engine.
+_CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(
+		DEVICEPTR(uchar) *entriesAllocType,
+		DEVICEPTR(uchar) *entriesVisibleType,
+		int x,
+		int y,
+		DEVICEPTR(Vector4s) *blockCoords,
+		const CONSTPTR(float) *depth,
+		Matrix4f invM_d,
+		Vector4f projParams_d,
+		float mu,
+		Vector2i imgSize,
+		float oneOverVoxelSize,
+		const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex,
+		float viewFrustum_min,
+		float viewFrustum_max,
+		int *locks
+) {
+	unsigned int hashIdx; int noSteps;
+	Vector3f point, direction; Vector3s blockPos;
+	const CONSTPTR(ITMHashEntry) *hashTable = voxelIndex->entries;
+
+	if (!computeAllocationRay(point, direction, noSteps, x, y, depth, invM_d, projParams_d, mu, imgSize,
+							  oneOverVoxelSize, viewFrustum_min, viewFrustum_max)) {
+		return;
+	}
 
 	// Walk the ray and flag blocks close (distance < mu) to the depth measurement for allocation,
 	// if necessary.
@@ -241,21 +305,20 @@ inline void buildHashAllocAndVisibleTypePP(
 		blockPos = TO_SHORT_FLOOR3(point);
 
 		//compute index in hash table
-		hashIdx = hashIndex(blockPos);
+		hashIdx = hashIndex(blockPos, voxelIndex->hashMask);
 
 		//check if hash table contains entry
 		bool isFound = false;
 
 		ITMHashEntry hashEntry = hashTable[hashIdx];
 
-#if defined(__CUDACC__) && defined(__CUDA_ARCH__)
 		int key = hashIdx;
-		int contention = atomicExch(&locks[key], BUCKET_LOCKED);
+		int contention = exchangeBucketLock(locks, key, BUCKET_LOCKED);
 		if (contention == BUCKET_LOCKED) {
 			point += direction;
 			continue;
 		}
-#endif
+
 		if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1)
 		{
 			//entry (has been streamed out but is visible) or (in memory and visible)
@@ -273,7 +336,7 @@ inline void buildHashAllocAndVisibleTypePP(
 				{
 					// Get the next element in the excess list by inspecting the appropriate hash
 					// table element.
-					hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+					hashIdx = voxelIndex->bucketNum + hashEntry.offset - 1;
 					hashEntry = hashTable[hashIdx];
 
 					if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1)
@@ -304,11 +367,71 @@ inline void buildHashAllocAndVisibleTypePP(
 			}
 		}
 
-#if defined(__CUDACC__) && defined(__CUDA_ARCH__)
-	// Release the lock on the bucket
-	atomicExch(&locks[key], BUCKET_UNLOCKED);
-#endif
+		// Release the lock on the bucket
+		exchangeBucketLock(locks, key, BUCKET_UNLOCKED);
+		point += direction;
+	}
+}
+
+/// \brief Open-addressing counterpart of buildHashAllocAndVisibleTypePP.
+///
+/// A missing block is requested at the first empty slot on its probe sequence, so all pixels
+/// seeing the same block issue the same request. Different blocks may compete for the same empty
+/// slot; the slot is locked while the request is written, the first block wins, and the others
+/// simply request again in the next frame, once the winner has been inserted.
+_CPU_AND_GPU_CODE_ inline void buildOpenHashAllocAndVisibleTypePP(
+		DEVICEPTR(uchar) *entriesAllocType,
+		DEVICEPTR(uchar) *entriesVisibleType,
+		int x,
+		int y,
+		DEVICEPTR(Vector4s) *blockCoords,
+		const CONSTPTR(float) *depth,
+		Matrix4f invM_d,
+		Vector4f projParams_d,
+		float mu,
+		Vector2i imgSize,
+		float oneOverVoxelSize,
+		const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+		float viewFrustum_min,
+		float viewFrustum_max,
+		int *locks
+) {
+	int noSteps;
+	Vector3f point, direction; Vector3s blockPos;
+
+	if (!computeAllocationRay(point, direction, noSteps, x, y, depth, invM_d, projParams_d, mu, imgSize,
+							  oneOverVoxelSize, viewFrustum_min, viewFrustum_max)) {
+		return;
+	}
+
+	for (int i = 0; i < noSteps; i++)
+	{
+		blockPos = TO_SHORT_FLOOR3(point);
 		point += direction;
+
+		int freeSlot;
+		int hashIdx = findBlockOrFreeSlot(voxelIndex, blockPos.toInt(), freeSlot);
+
+		if (hashIdx >= 0)
+		{
+			//entry (has been streamed out but is visible) or (in memory and visible)
+			entriesVisibleType[hashIdx] = (voxelIndex->entries[hashIdx].ptr == -1) ? 2 : 1;
+			continue;
+		}
+
+		// The table is full. Cannot happen as long as it has more slots than the VBA has blocks.
+		if (freeSlot < 0) continue;
+
+		if (exchangeBucketLock(locks, freeSlot, BUCKET_LOCKED) == BUCKET_LOCKED) continue;
+
+		if (entriesAllocType[freeSlot] == 0)
+		{
+			entriesAllocType[freeSlot] = 1;		// needs allocation
+			entriesVisibleType[freeSlot] = 1;	// new entry is visible
+			blockCoords[freeSlot] = Vector4s(blockPos.x, blockPos.y, blockPos.z, 1);
+		}
+
+		exchangeBucketLock(locks, freeSlot, BUCKET_UNLOCKED);
 	}
 }
 
@@ -126,10 +126,17 @@ _CPU_AND_GPU_CODE_ inline bool castRay(DEVICEPTR(Vector4f) &pt_out, int x, int y
 
 	pt_result = pt_block_s;
 
-	typename TIndex::IndexCache cache;
+	SDFSampler<TVoxel, typename TIndex::IndexData> sampler(voxelData, voxelIndex);
 
 	while (totalLength < totalLengthMax) {
-		sdfValue = readFromSDF_float_uninterpolated(voxelData, voxelIndex, pt_result, hash_found, cache);
+		// Empty space in the occupancy grid of the index is skipped in one step, without lookups.
+		float skipLength = emptyRegionSkipLength(voxelIndex, pt_result, rayDirection);
+		if (skipLength > 0.0f) {
+			pt_result += skipLength * rayDirection; totalLength += skipLength;
+			continue;
+		}
+
+		sdfValue = readFromSDF_float_uninterpolated(sampler, pt_result, hash_found);
 
 		if (!hash_found) {
 			stepLength = SDF_BLOCK_SIZE;
@@ -141,7 +148,7 @@ _CPU_AND_GPU_CODE_ inline bool castRay(DEVICEPTR(Vector4f) &pt_out, int x, int y
 			float maxSdf = 20.0;
 			float minSdf = -100.0f;
 			if ((sdfValue <= maxSdf) && (sdfValue >= minSdf)) {
-				sdfValue = readFromSDF_float_interpolated(voxelData, voxelIndex, pt_result, hash_found, cache);
+				sdfValue = readFromSDF_float_interpolated(sampler, pt_result, hash_found);
 			}
 			if (sdfValue <= 0.0f) {
 				break;
@@ -159,7 +166,7 @@ _CPU_AND_GPU_CODE_ inline bool castRay(DEVICEPTR(Vector4f) &pt_out, int x, int y
 		stepLength = sdfValue * stepScale;
 		pt_result += stepLength * rayDirection;
 
-		sdfValue = readFromSDF_float_interpolated(voxelData, voxelIndex, pt_result, hash_found, cache);
+		sdfValue = readFromSDF_float_interpolated(sampler, pt_result, hash_found);
 		stepLength = sdfValue * stepScale;
 		pt_result += stepLength * rayDirection;
 
@@ -345,7 +352,7 @@ _CPU_AND_GPU_CODE_ inline void drawPixelWeight(
 	findVoxel(indexData, ipos, isFound, blockIdx, outPrevBlockIdx);
 
 	// Whether the block is in the excess list AND we care about coloring it differently because of it.
-	bool isExcess = (blockIdx >= SDF_BUCKET_NUM) && params.differentiateOrderedExcess;
+	bool isExcess = isExcessEntry(indexData, blockIdx) && params.differentiateOrderedExcess;
 	Vector4u saturatedColor = isExcess ? Vector4u(0, 0, 128, 255) : Vector4u(0, 0, 255, 255);
 	Vector4u noisyColor = isExcess ? Vector4u(255, 255, 0, 255) : Vector4u(255, 0, 0, 255);
 	Vector4u gradualColor = isExcess ? Vector4u(50, intensity, 255, 255) : Vector4u(intensity, intensity, intensity, 255);
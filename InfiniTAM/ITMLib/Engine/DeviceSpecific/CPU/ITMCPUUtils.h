@@ -0,0 +1,17 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+// CPU counterparts of the CUDA atomics used by the voxel hashing kernels. When OpenMP is disabled
+// the engines run single-threaded, so plain read-modify-write sequences are sufficient.
+
+template <typename T>
+inline T atomicAdd_CPU(T *address, T val)
+{
+	T old;
+#ifdef WITH_OPENMP
+	#pragma omp atomic capture
+#endif
+	{ old = *address; *address += val; }
+	return old;
+}
@@ -2,79 +2,1159 @@
 
 #include "ITMMeshingEngine_CPU.h"
 #include "../../DeviceAgnostic/ITMMeshingEngine.h"
+#include "../../../../ORUtils/StreamCompaction.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Checks every mesh built from the block cache against a mesh of the entire scene, and throws if
+// they differ. Costs a full meshing on every call.
+//#define MESH_CACHE_DEBUG
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
 
 using namespace ITMLib::Engine;
 
+namespace
+{
+	/// Number of consecutive allocated blocks meshed by one task of the parallel loop.
+	const int meshingBatchSize = 32;
+
+	/// Number of planes in z and of rows in y of the bricks a dense volume is meshed in.
+	const int plainBrickSize = 8;
+
+	/// \brief The elements (triangles or vertices) emitted by one thread. They are stored in
+	///        chunks of fixed size, so that growing the buffer never moves the elements already in it.
+	template<class T>
+	class ChunkBuffer
+	{
+		static const int chunkSize = 4096;
+		std::vector<std::vector<T> > chunks;
+		int noElements = 0;
+
+	public:
+		int size() const { return noElements; }
+
+		T& push_back()
+		{
+			if (noElements == static_cast<int>(chunks.size()) * chunkSize) {
+				chunks.push_back(std::vector<T>(chunkSize));
+			}
+			T &element = chunks[noElements / chunkSize][noElements % chunkSize];
+			noElements++;
+			return element;
+		}
+
+		const T& operator[](int idx) const { return chunks[idx / chunkSize][idx % chunkSize]; }
+
+		/// \brief Copies the elements [begin, begin + count) to out.
+		void CopyTo(T *out, int begin, int count) const
+		{
+			while (count > 0) {
+				int chunkIdx = begin / chunkSize, chunkOffset = begin % chunkSize;
+				int noCopied = MIN(count, chunkSize - chunkOffset);
+				std::copy(chunks[chunkIdx].begin() + chunkOffset, chunks[chunkIdx].begin() + chunkOffset + noCopied, out);
+				out += noCopied; begin += noCopied; count -= noCopied;
+			}
+		}
+	};
+
+	/// \brief A vertex on a grid edge, which the indexed mesher knows by the edge it is on: the
+	///        edge from voxel v to v + e_axis is edge blockEdgeIdx(v, axis) of the block of v.
+	struct EdgeVertex {
+		int edgeIdx;
+		ITMMesh::Vertex vertex;
+	};
+
+	/// \brief Index of the edge from the voxel at (x, y, z) in its block along axis. The edges are
+	///        numbered in raster order, whatever the voxel order inside blocks, so that the vertices
+	///        of a block, which are created in raster order, are sorted by edge.
+	inline int blockEdgeIdx(int x, int y, int z, int axis)
+	{
+		return (x + (y + z * SDF_BLOCK_SIZE) * SDF_BLOCK_SIZE) * 3 + axis;
+	}
+
+	/// The edges of a marching cubes cell, numbered as in edgeTable, as the corner at their lower
+	/// end and the axis along which they run.
+	const int cellEdgeCorners[12][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 0 }, { 0, 0, 1 }, { 1, 0, 1 },
+		{ 0, 1, 1 }, { 0, 0, 1 }, { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 } };
+	const int cellEdgeAxes[12] = { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 };
+
+	/// \brief Where the elements emitted for every work item (a block or a batch of blocks) of a
+	///        parallel loop went: the thread, and their range in its ChunkBuffer. Scan turns the
+	///        counts into the offsets of the items in the output, in item order.
+	template<class T>
+	struct OutputRanges
+	{
+		std::vector<int> thread, begin, offsets;
+
+		explicit OutputRanges(int noItems) : thread(noItems), begin(noItems), offsets(noItems + 1, 0) {}
+
+		void Start(int itemIdx, int threadId, const ChunkBuffer<T> &buffer) { thread[itemIdx] = threadId; begin[itemIdx] = buffer.size(); }
+		void End(int itemIdx, const ChunkBuffer<T> &buffer) { offsets[itemIdx + 1] = buffer.size() - begin[itemIdx]; }
+		int Count(int itemIdx) const { return offsets[itemIdx + 1] - offsets[itemIdx]; }
+
+		/// \brief Exclusive scan over the counts. Returns the total.
+		int Scan()
+		{
+			for (size_t itemIdx = 1; itemIdx < offsets.size(); itemIdx++) offsets[itemIdx] += offsets[itemIdx - 1];
+			return offsets.back();
+		}
+
+		/// \brief Copies the elements of all the items to out, in item order.
+		void Gather(const std::vector<ChunkBuffer<T> > &buffers, T *out) const
+		{
+			int noItems = static_cast<int>(thread.size());
+#ifdef WITH_OPENMP
+			#pragma omp parallel for schedule(static)
+#endif
+			for (int itemIdx = 0; itemIdx < noItems; itemIdx++)
+				buffers[thread[itemIdx]].CopyTo(out + offsets[itemIdx], begin[itemIdx], Count(itemIdx));
+		}
+	};
+
+	int GetThreadNum()
+	{
+#ifdef WITH_OPENMP
+		return omp_get_thread_num();
+#else
+		return 0;
+#endif
+	}
+
+	int GetMaxThreads()
+	{
+#ifdef WITH_OPENMP
+		return omp_get_max_threads();
+#else
+		return 1;
+#endif
+	}
+}
+
+/// \brief Lists the position (of the first voxel) and VBA slot of every allocated block of a
+///        hashed scene, in hash table order. While a hash table grows, the blocks which have not
+///        been migrated yet are in the old table, which is listed after the current one.
+template<class TVoxel, class TIndex>
+static int GetAllocatedBlocks(const ITMScene<TVoxel, TIndex> *scene, std::vector<Vector3i> &blockPositions,
+	std::vector<int> &blockPtrs)
+{
+	const ITMHashEntry *hashTable = scene->index.GetEntries();
+	const ITMHashEntry *oldHashTable = scene->index.GetOldEntries();
+	int noTotalEntries = scene->index.noTotalEntries;
+	int noOldEntries = scene->index.getOldNoTotalEntries();
+
+	auto getEntry = [=](int entryId) -> const ITMHashEntry & {
+		return (entryId < noTotalEntries) ? hashTable[entryId] : oldHashTable[entryId - noTotalEntries];
+	};
+
+	blockPositions.resize(noTotalEntries + noOldEntries);
+	blockPtrs.resize(noTotalEntries + noOldEntries);
+	Vector3i *positions = blockPositions.data();
+	int *ptrs = blockPtrs.data();
+
+	int noBlocks = ORUtils::compactStream(noTotalEntries + noOldEntries,
+		[=](int entryId) { return getEntry(entryId).ptr >= 0; },
+		[=](int blockIdx, int entryId) {
+			positions[blockIdx] = getEntry(entryId).pos.toInt() * SDF_BLOCK_SIZE;
+			ptrs[blockIdx] = getEntry(entryId).ptr;
+		});
+
+	blockPositions.resize(noBlocks);
+	blockPtrs.resize(noBlocks);
+	return noBlocks;
+}
+
+/// \brief Runs marching cubes over the cells of the block of a hashed scene whose first voxel is at
+///        globalPos, i.e., the cells whose first corner is one of its voxels. Hands every triangle
+///        to newTriangle, which returns where to store it.
+template<class TVoxel, class TIndex, class TNewTriangle>
+static void MeshBlock(const ITMScene<TVoxel, TIndex> *scene, const Vector3i &globalPos,
+	TNewTriangle newTriangle)
+{
+	const TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
+	float factor = scene->sceneParams->voxelSize;
+
+	for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+	{
+		Vector3f vertList[12];
+		int cubeIndex = buildVertList(vertList, globalPos, Vector3i(x, y, z), localVBA, voxelIndex);
+
+		if (cubeIndex < 0) continue;
+
+		for (int i = 0; triangleTable[cubeIndex][i] != -1; i += 3)
+		{
+			ITMMesh::Triangle &triangle = newTriangle();
+			Vector3f p0 = vertList[triangleTable[cubeIndex][i]];
+			Vector3f p1 = vertList[triangleTable[cubeIndex][i + 1]];
+			Vector3f p2 = vertList[triangleTable[cubeIndex][i + 2]];
+			triangle.p0 = p0 * factor;
+			triangle.p1 = p1 * factor;
+			triangle.p2 = p2 * factor;
+
+			triangle.c0 = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate3(localVBA, voxelIndex, p0);
+			triangle.c1 = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate3(localVBA, voxelIndex, p1);
+			triangle.c2 = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate3(localVBA, voxelIndex, p2);
+		}
+	}
+}
+
+/// \brief Creates the vertices on the edges owned by the block whose first voxel is at globalPos
+///        (those which start at one of its voxels) which the surface crosses, in edge order, and
+///        hands them to newVertex, which returns where to store them.
+template<class TVoxel, class TIndex, class TNewVertex>
+static void CreateEdgeVertices(const ITMScene<TVoxel, TIndex> *scene, const Vector3i &globalPos,
+	TNewVertex newVertex)
+{
+	const TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
+	float factor = scene->sceneParams->voxelSize;
+
+	SDFSampler<TVoxel, typename TIndex::IndexData> sampler(localVBA, voxelIndex);
+	sampler.prepare(globalPos, globalPos + Vector3i(SDF_BLOCK_SIZE, SDF_BLOCK_SIZE, SDF_BLOCK_SIZE));
+
+	for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+	{
+		// Only observed voxels are corners of cells which findPointNeighbors accepts.
+		Vector3i p0 = globalPos + Vector3i(x, y, z);
+		bool isFound;
+		float sdf0 = TVoxel::SDF_valueToFloat(sampler.sdfAt(p0, isFound));
+		if (!isFound || sdf0 == 1.0f) continue;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			Vector3i p1 = p0; p1[axis]++;
+			float sdf1 = TVoxel::SDF_valueToFloat(sampler.sdfAt(p1, isFound));
+			if (!isFound || sdf1 == 1.0f || (sdf0 < 0) == (sdf1 < 0)) continue;
+
+			Vector3f point = sdfInterp(p0.toFloat(), p1.toFloat(), sdf0, sdf1);
+			EdgeVertex &edgeVertex = newVertex();
+			edgeVertex.edgeIdx = blockEdgeIdx(x, y, z, axis);
+			edgeVertex.vertex.p = point * factor;
+			edgeVertex.vertex.c = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate3(localVBA, voxelIndex, point);
+		}
+	}
+}
+
+/// \brief Runs marching cubes over the cells of the block whose first voxel is at globalPos, like
+///        MeshBlock, but hands every triangle to newTriangle as the edges its corners are on: for
+///        every corner, the owner of the edge (0 for the block itself, and 1 to 7 for its
+///        neighbours in +x, +y and +z, indexed like the blocks of SDFSampler), and the index of the
+///        edge in the owner.
+template<class TVoxel, class TIndex, class TNewTriangle>
+static void MeshBlockEdges(const ITMScene<TVoxel, TIndex> *scene, const Vector3i &globalPos,
+	TNewTriangle newTriangle)
+{
+	SDFSampler<TVoxel, typename TIndex::IndexData> sampler(scene->localVBA.GetVoxelBlocks(), scene->index.getIndexData());
+	sampler.prepare(globalPos, globalPos + Vector3i(SDF_BLOCK_SIZE, SDF_BLOCK_SIZE, SDF_BLOCK_SIZE));
+
+	for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+	{
+		// The same cells as buildVertList: all corners observed, and the surface crossing some edge.
+		int cubeIndex = 0;
+		bool isValidCell = true;
+		for (int corner = 0; corner < 8 && isValidCell; corner++)
+		{
+			// The corners in the order of findPointNeighbors.
+			Vector3i cornerPos = globalPos + Vector3i(x + ((corner + 1) >> 1 & 1), y + (corner >> 1 & 1), z + (corner >> 2));
+			bool isFound;
+			float sdf = TVoxel::SDF_valueToFloat(sampler.sdfAt(cornerPos, isFound));
+			isValidCell = isFound && sdf != 1.0f;
+			if (sdf < 0) cubeIndex |= 1 << corner;
+		}
+		if (!isValidCell || edgeTable[cubeIndex] == 0) continue;
+
+		for (int i = 0; triangleTable[cubeIndex][i] != -1; i += 3)
+		{
+			int owners[3], edgeIdxs[3];
+			for (int k = 0; k < 3; k++)
+			{
+				int edge = triangleTable[cubeIndex][i + k];
+				Vector3i owner(x + cellEdgeCorners[edge][0], y + cellEdgeCorners[edge][1], z + cellEdgeCorners[edge][2]);
+				owners[k] = (owner.x / SDF_BLOCK_SIZE) | ((owner.y / SDF_BLOCK_SIZE) << 1) | ((owner.z / SDF_BLOCK_SIZE) << 2);
+				edgeIdxs[k] = blockEdgeIdx(owner.x % SDF_BLOCK_SIZE, owner.y % SDF_BLOCK_SIZE, owner.z % SDF_BLOCK_SIZE, cellEdgeAxes[edge]);
+			}
+			newTriangle(owners, edgeIdxs);
+		}
+	}
+}
+
+/// \brief Finds the vertex of an edge in the vertices of its owner, which are in edge order.
+///        Returns its index in [begin, end), or -1 if the owner has no vertex on the edge.
+static int FindEdgeVertex(const EdgeVertex *begin, const EdgeVertex *end, int edgeIdx)
+{
+	const EdgeVertex *found = std::lower_bound(begin, end, edgeIdx,
+		[](const EdgeVertex &edgeVertex, int edgeIdx) { return edgeVertex.edgeIdx < edgeIdx; });
+	return (found != end && found->edgeIdx == edgeIdx) ? static_cast<int>(found - begin) : -1;
+}
+
+/// \brief Fills an indexed mesh with the triangles, which are given as indices into edgeVertices,
+///        dropping the vertices which no triangle refers to (those around cells with unobserved
+///        corners) and remapping the indices.
+static void WriteIndexedMesh(ITMMesh *mesh, const std::vector<EdgeVertex> &edgeVertices, const std::vector<Vector3i> &triangles)
+{
+	int noEdgeVertices = static_cast<int>(edgeVertices.size());
+	int noTriangles = static_cast<int>(triangles.size());
+
+	std::vector<unsigned char> isVertexUsed(noEdgeVertices, 0);
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int triangleIdx = 0; triangleIdx < noTriangles; triangleIdx++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+#ifdef WITH_OPENMP
+			#pragma omp atomic write
+#endif
+			isVertexUsed[triangles[triangleIdx][k]] = 1;
+		}
+	}
+
+	std::vector<int> vertexRemap(noEdgeVertices, -1);
+	int *remap = vertexRemap.data();
+	const unsigned char *isUsed = isVertexUsed.data();
+	int noVertices = ORUtils::compactStream(noEdgeVertices,
+		[=](int edgeVertexIdx) { return isUsed[edgeVertexIdx] != 0; },
+		[=](int vertexIdx, int edgeVertexIdx) { remap[edgeVertexIdx] = vertexIdx; });
+
+	mesh->Reserve(noTriangles, noVertices);
+	ITMMesh::Vertex *meshVertices = mesh->vertices->GetData(MEMORYDEVICE_CPU);
+	uint *meshIndices = mesh->indices->GetData(MEMORYDEVICE_CPU);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int edgeVertexIdx = 0; edgeVertexIdx < noEdgeVertices; edgeVertexIdx++)
+	{
+		if (remap[edgeVertexIdx] >= 0) meshVertices[remap[edgeVertexIdx]] = edgeVertices[edgeVertexIdx].vertex;
+	}
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int triangleIdx = 0; triangleIdx < noTriangles; triangleIdx++)
+	{
+		for (int k = 0; k < 3; k++) meshIndices[triangleIdx * 3 + k] = static_cast<uint>(remap[triangles[triangleIdx][k]]);
+	}
+
+	mesh->noTotalVertices = noVertices;
+	mesh->noTotalTriangles = noTriangles;
+}
+
+/// \brief Runs marching cubes over a list of allocated blocks of a hashed scene, given by the
+///        positions of their first voxels. Works with any index which stores ITMHashEntry elements,
+///        i.e., ITMVoxelBlockHash and ITMVoxelBlockOpenHash.
+///
+/// The blocks are meshed in batches, in parallel. Every thread appends the triangles of its
+/// batches to its own buffer, and the batches are then copied into the mesh in order. The mesh
+/// therefore has the triangles in the order of the block list, no matter how many threads there
+/// are, and grows if it is too small to take them all.
+template<class TVoxel, class TIndex>
+static void MeshBlocks_common(ITMMesh *mesh, const ITMScene<TVoxel, TIndex> *scene,
+	const Vector3i *positions, int noBlocks)
+{
+	int noBatches = (noBlocks + meshingBatchSize - 1) / meshingBatchSize;
+	std::vector<ChunkBuffer<ITMMesh::Triangle> > threadTriangles(GetMaxThreads());
+	OutputRanges<ITMMesh::Triangle> batchTriangles(noBatches);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int batchIdx = 0; batchIdx < noBatches; batchIdx++)
+	{
+		int threadId = GetThreadNum();
+		ChunkBuffer<ITMMesh::Triangle> &triangles = threadTriangles[threadId];
+		batchTriangles.Start(batchIdx, threadId, triangles);
+
+		int blockEnd = MIN(noBlocks, (batchIdx + 1) * meshingBatchSize);
+		for (int blockIdx = batchIdx * meshingBatchSize; blockIdx < blockEnd; blockIdx++)
+			MeshBlock(scene, positions[blockIdx], [&]() -> ITMMesh::Triangle & { return triangles.push_back(); });
+
+		batchTriangles.End(batchIdx, triangles);
+	}
+
+	int noTriangles = batchTriangles.Scan();
+	mesh->Reserve(noTriangles);
+	batchTriangles.Gather(threadTriangles, mesh->triangles->GetData(MEMORYDEVICE_CPU));
+
+	mesh->noTotalTriangles = noTriangles;
+}
+
+/// \brief Like MeshBlocks_common, but builds an indexed mesh. Every vertex lies on an edge of the
+///        voxel grid, and the vertices are welded by the edge they are on while the cells are
+///        meshed, in three parallel passes over the blocks:
+///  - Every block creates the vertices on the edges it owns (those which start at one of its
+///    voxels) which the surface crosses, in edge order.
+///  - Every block meshes its cells. The triangles refer to the vertices of the edges of the cells,
+///    which are looked up in the lists of the owning blocks, i.e., the block or its neighbours in
+///    +x, +y and +z.
+///  - The vertices which no triangle refers to (those around cells with unobserved corners) are
+///    removed, and the indices remapped.
+/// The result is the same for any number of threads.
+///
+/// Only the first noMeshedBlocks blocks of the list are meshed. The others only contribute the
+/// vertices on their edges, so they should include the neighbours of the meshed blocks. blockOfPtr
+/// maps the VBA slots of the listed blocks to their positions in the list, and is -1 elsewhere.
+template<class TVoxel, class TIndex>
+static void MeshBlocksIndexed_common(ITMMesh *mesh, const ITMScene<TVoxel, TIndex> *scene,
+	const Vector3i *positions, int noMeshedBlocks, int noBlocks, const std::vector<int> &blockOfPtr)
+{
+	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
+	int maxThreads = GetMaxThreads();
+
+	// Pass 1: the vertices of the edges owned by every block.
+	std::vector<ChunkBuffer<EdgeVertex> > threadVertices(maxThreads);
+	OutputRanges<EdgeVertex> blockVertices(noBlocks);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, meshingBatchSize)
+#endif
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++)
+	{
+		int threadId = GetThreadNum();
+		ChunkBuffer<EdgeVertex> &vertices = threadVertices[threadId];
+		blockVertices.Start(blockIdx, threadId, vertices);
+
+		CreateEdgeVertices(scene, positions[blockIdx], [&]() -> EdgeVertex & { return vertices.push_back(); });
+
+		blockVertices.End(blockIdx, vertices);
+	}
+
+	int noEdgeVertices = blockVertices.Scan();
+	std::vector<EdgeVertex> edgeVertices(noEdgeVertices);
+	blockVertices.Gather(threadVertices, edgeVertices.data());
+	threadVertices.clear();
+
+	// Pass 2: the triangles, as indices into edgeVertices.
+	std::vector<ChunkBuffer<Vector3i> > threadTriangles(maxThreads);
+	OutputRanges<Vector3i> blockTriangles(noMeshedBlocks);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, meshingBatchSize)
+#endif
+	for (int blockIdx = 0; blockIdx < noMeshedBlocks; blockIdx++)
+	{
+		int threadId = GetThreadNum();
+		ChunkBuffer<Vector3i> &triangles = threadTriangles[threadId];
+		blockTriangles.Start(blockIdx, threadId, triangles);
+
+		Vector3i globalPos = positions[blockIdx];
+
+		// The block and its neighbours in +x, +y and +z, indexed like the blocks of the sampler.
+		int neighbourBlocks[8];
+		for (int neighbourIdx = 0; neighbourIdx < 8; neighbourIdx++)
+		{
+			Vector3i offset(neighbourIdx & 1, (neighbourIdx >> 1) & 1, neighbourIdx >> 2);
+			bool isFound = false;
+			int voxelIdx = findVoxel(voxelIndex, globalPos + offset * SDF_BLOCK_SIZE, isFound);
+			neighbourBlocks[neighbourIdx] = isFound ? blockOfPtr[voxelIdx / SDF_BLOCK_SIZE3] : -1;
+		}
+
+		MeshBlockEdges(scene, globalPos, [&](const int *owners, const int *edgeIdxs) {
+			Vector3i triangle;
+			for (int k = 0; k < 3; k++)
+			{
+				// Both ends of the edge are observed corners with different signs, so the owner
+				// created its vertex in the first pass.
+				int ownerBlockIdx = neighbourBlocks[owners[k]];
+				if (ownerBlockIdx < 0) return;
+
+				int begin = blockVertices.offsets[ownerBlockIdx];
+				int vertexIdx = FindEdgeVertex(edgeVertices.data() + begin, edgeVertices.data() + blockVertices.offsets[ownerBlockIdx + 1],
+					edgeIdxs[k]);
+				if (vertexIdx < 0) return;
+				triangle[k] = begin + vertexIdx;
+			}
+			triangles.push_back() = triangle;
+		});
+
+		blockTriangles.End(blockIdx, triangles);
+	}
+
+	int noTriangles = blockTriangles.Scan();
+	std::vector<Vector3i> triangles(noTriangles);
+	blockTriangles.Gather(threadTriangles, triangles.data());
+	threadTriangles.clear();
+
+	// Pass 3: drop the unused vertices.
+	WriteIndexedMesh(mesh, edgeVertices, triangles);
+}
+
+template<class TVoxel, class TIndex>
+static void MeshScene_common(ITMMesh *mesh, const ITMScene<TVoxel, TIndex> *scene)
+{
+	std::vector<Vector3i> blockPositions;
+	std::vector<int> blockPtrs;
+	int noBlocks = GetAllocatedBlocks(scene, blockPositions, blockPtrs);
+
+	if (mesh->isIndexed) {
+		std::vector<int> blockOfPtr(scene->localVBA.allocatedSize / SDF_BLOCK_SIZE3, -1);
+		for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++) blockOfPtr[blockPtrs[blockIdx]] = blockIdx;
+
+		MeshBlocksIndexed_common(mesh, scene, blockPositions.data(), noBlocks, noBlocks, blockOfPtr);
+	}
+	else MeshBlocks_common(mesh, scene, blockPositions.data(), noBlocks);
+}
+
+/// The cached mesh of a block is an indexed or a non-indexed mesh, like the mesh it was made for.
+/// Indexed blocks keep the vertices on the edges they own, and their triangles as the edges their
+/// corners are on, along with where the vertices of these edges are in the lists of their owners.
+/// When the owners are meshed again, the triangles are only pointed to the new lists, which does not
+/// need the block to be meshed again.
+struct ITMLib::Engine::ITMMeshBlockCache
+{
+	struct Block
+	{
+		bool isValid = false;
+		/// The position of the block's first voxel, and the count of its changes, when it was meshed.
+		Vector3i position;
+		unsigned int version = 0;
+
+		std::vector<ITMMesh::Triangle> triangles;
+
+		/// The VBA slots of the block and its neighbours in +x, +y and +z, indexed like the blocks
+		/// of SDFSampler, or -1 for those which are not allocated.
+		int neighbourPtrs[8];
+		std::vector<EdgeVertex> vertices;
+		/// The corners of the triangles, as (edgeIdx << 14) | (vertexIdx << 3) | owner, where
+		/// owner and edgeIdx are as in MeshBlockEdges, and vertexIdx is the index of the vertex in
+		/// the vertices of the owner.
+		std::vector<Vector3i> edgeTriangles;
+	};
+
+	const void *scene = NULL;
+	bool isIndexed = false;
+	/// By VBA slot.
+	std::vector<Block> blocks;
+};
+
+/// \brief Brings the cached meshes of the blocks of a hashed scene up to date, and builds the mesh
+///        from them, in the same order as MeshScene_common. Produces the same mesh.
+///
+/// A block is changed if its count of changes (see ITMLocalVBA::VoxelsChanged) is not the one it
+/// was meshed at, or if its VBA slot now holds another block, or none. The cells of a block read
+/// the voxels of its neighbours in +x, +y and +z, so the blocks which are meshed again are those
+/// in -x, -y and -z of the changed blocks, at their old positions and at their new ones.
+template<class TVoxel, class TIndex>
+static void MeshSceneFromCache_common(ITMMeshBlockCache &cache, ITMMesh *mesh, const ITMScene<TVoxel, TIndex> *scene)
+{
+	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
+	const unsigned int *versions = scene->localVBA.GetBlockVersions();
+	int noSlots = scene->localVBA.allocatedSize / SDF_BLOCK_SIZE3;
+
+	if (cache.scene != scene || cache.isIndexed != mesh->isIndexed || static_cast<int>(cache.blocks.size()) != noSlots)
+	{
+		cache.blocks.clear();
+		cache.blocks.resize(noSlots);
+		cache.scene = scene;
+		cache.isIndexed = mesh->isIndexed;
+	}
+	ITMMeshBlockCache::Block *blocks = cache.blocks.data();
+
+	std::vector<Vector3i> blockPositions;
+	std::vector<int> blockPtrs;
+	int noBlocks = GetAllocatedBlocks(scene, blockPositions, blockPtrs);
+	const Vector3i *positions = blockPositions.data();
+	const int *ptrs = blockPtrs.data();
+
+	std::vector<int> blockOfPtr(noSlots, -1);
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++) blockOfPtr[ptrs[blockIdx]] = blockIdx;
+	const int *blockOf = blockOfPtr.data();
+
+	std::vector<int> changedSlots(noSlots);
+	int *changed = changedSlots.data();
+	int noChangedSlots = ORUtils::compactStream(noSlots,
+		[=](int ptr) {
+			const ITMMeshBlockCache::Block &block = blocks[ptr];
+			if (blockOf[ptr] < 0) return block.isValid;
+			return !block.isValid || block.position != positions[blockOf[ptr]] || block.version != versions[ptr];
+		},
+		[=](int changedIdx, int ptr) { changed[changedIdx] = ptr; });
+
+	std::vector<unsigned char> isDirtySlot(noSlots, 0);
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int changedIdx = 0; changedIdx < noChangedSlots; changedIdx++)
+	{
+		int ptr = changed[changedIdx];
+		Vector3i changedPositions[2];
+		int noChangedPositions = 0;
+		if (blocks[ptr].isValid) changedPositions[noChangedPositions++] = blocks[ptr].position;
+		if (blockOf[ptr] >= 0) changedPositions[noChangedPositions++] = positions[blockOf[ptr]];
+
+		for (int positionIdx = 0; positionIdx < noChangedPositions; positionIdx++) for (int neighbourIdx = 0; neighbourIdx < 8; neighbourIdx++)
+		{
+			Vector3i offset(neighbourIdx & 1, (neighbourIdx >> 1) & 1, neighbourIdx >> 2);
+			bool isFound = false;
+			int voxelIdx = findVoxel(voxelIndex, changedPositions[positionIdx] - offset * SDF_BLOCK_SIZE, isFound);
+			if (!isFound) continue;
+#ifdef WITH_OPENMP
+			#pragma omp atomic write
+#endif
+			isDirtySlot[voxelIdx / SDF_BLOCK_SIZE3] = 1;
+		}
+	}
+
+	// The blocks which are gone.
+	for (int changedIdx = 0; changedIdx < noChangedSlots; changedIdx++)
+	{
+		if (blockOf[changed[changedIdx]] < 0) blocks[changed[changedIdx]] = ITMMeshBlockCache::Block();
+	}
+
+	std::vector<int> dirtyBlocks(noBlocks);
+	int *dirty = dirtyBlocks.data();
+	const unsigned char *isDirty = isDirtySlot.data();
+	int noDirtyBlocks = ORUtils::compactStream(noBlocks,
+		[=](int blockIdx) { return isDirty[ptrs[blockIdx]] != 0; },
+		[=](int dirtyIdx, int blockIdx) { dirty[dirtyIdx] = blockIdx; });
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int dirtyIdx = 0; dirtyIdx < noDirtyBlocks; dirtyIdx++)
+	{
+		int blockIdx = dirty[dirtyIdx];
+		ITMMeshBlockCache::Block &block = blocks[ptrs[blockIdx]];
+		block.isValid = true;
+		block.position = positions[blockIdx];
+		block.version = versions[ptrs[blockIdx]];
+
+		if (cache.isIndexed)
+		{
+			block.vertices.clear();
+			CreateEdgeVertices(scene, block.position,
+				[&]() -> EdgeVertex & { block.vertices.push_back(EdgeVertex()); return block.vertices.back(); });
+		}
+		else
+		{
+			block.triangles.clear();
+			MeshBlock(scene, block.position,
+				[&]() -> ITMMesh::Triangle & { block.triangles.push_back(ITMMesh::Triangle()); return block.triangles.back(); });
+		}
+	}
+
+	if (cache.isIndexed)
+	{
+		// The triangles, once the vertices of all the owners they refer to are up to date.
+#ifdef WITH_OPENMP
+		#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int dirtyIdx = 0; dirtyIdx < noDirtyBlocks; dirtyIdx++)
+		{
+			ITMMeshBlockCache::Block &block = blocks[ptrs[dirty[dirtyIdx]]];
+
+			for (int neighbourIdx = 0; neighbourIdx < 8; neighbourIdx++)
+			{
+				Vector3i offset(neighbourIdx & 1, (neighbourIdx >> 1) & 1, neighbourIdx >> 2);
+				bool isFound = false;
+				int voxelIdx = findVoxel(voxelIndex, block.position + offset * SDF_BLOCK_SIZE, isFound);
+				block.neighbourPtrs[neighbourIdx] = isFound ? voxelIdx / SDF_BLOCK_SIZE3 : -1;
+			}
+
+			block.edgeTriangles.clear();
+			MeshBlockEdges(scene, block.position, [&](const int *owners, const int *edgeIdxs) {
+				Vector3i edgeTriangle;
+				for (int k = 0; k < 3; k++)
+				{
+					int ownerPtr = block.neighbourPtrs[owners[k]];
+					if (ownerPtr < 0) return;
+
+					const std::vector<EdgeVertex> &ownerVertices = blocks[ownerPtr].vertices;
+					int vertexIdx = FindEdgeVertex(ownerVertices.data(), ownerVertices.data() + ownerVertices.size(), edgeIdxs[k]);
+					if (vertexIdx < 0) return;
+					edgeTriangle[k] = (edgeIdxs[k] << 14) | (vertexIdx << 3) | owners[k];
+				}
+				block.edgeTriangles.push_back(edgeTriangle);
+			});
+		}
+
+		// The blocks which were not meshed again, but whose triangles refer to the vertices of some
+		// which were.
+		std::vector<unsigned char> isStaleSlot(noSlots, 0);
+#ifdef WITH_OPENMP
+		#pragma omp parallel for
+#endif
+		for (int dirtyIdx = 0; dirtyIdx < noDirtyBlocks; dirtyIdx++)
+		{
+			for (int neighbourIdx = 1; neighbourIdx < 8; neighbourIdx++)
+			{
+				Vector3i offset(neighbourIdx & 1, (neighbourIdx >> 1) & 1, neighbourIdx >> 2);
+				bool isFound = false;
+				int voxelIdx = findVoxel(voxelIndex, positions[dirty[dirtyIdx]] - offset * SDF_BLOCK_SIZE, isFound);
+				if (!isFound || isDirty[voxelIdx / SDF_BLOCK_SIZE3]) continue;
+#ifdef WITH_OPENMP
+				#pragma omp atomic write
+#endif
+				isStaleSlot[voxelIdx / SDF_BLOCK_SIZE3] = 1;
+			}
+		}
+
+#ifdef WITH_OPENMP
+		#pragma omp parallel for schedule(dynamic, meshingBatchSize)
+#endif
+		for (int ptr = 0; ptr < noSlots; ptr++)
+		{
+			if (!isStaleSlot[ptr]) continue;
+
+			// The triangles whose vertex is gone from their owner are dropped, like MeshBlockEdges
+			// would drop them.
+			ITMMeshBlockCache::Block &block = blocks[ptr];
+			size_t noKept = 0;
+			for (size_t triangleIdx = 0; triangleIdx < block.edgeTriangles.size(); triangleIdx++)
+			{
+				Vector3i edgeTriangle = block.edgeTriangles[triangleIdx];
+				bool isFound = true;
+				for (int k = 0; k < 3 && isFound; k++)
+				{
+					int &corner = edgeTriangle[k];
+					const std::vector<EdgeVertex> &ownerVertices = blocks[block.neighbourPtrs[corner & 7]].vertices;
+					int vertexIdx = FindEdgeVertex(ownerVertices.data(), ownerVertices.data() + ownerVertices.size(), corner >> 14);
+					isFound = vertexIdx >= 0;
+					if (isFound) corner = (corner & ~(0x7ff << 3)) | (vertexIdx << 3);
+				}
+				if (isFound) block.edgeTriangles[noKept++] = edgeTriangle;
+			}
+			block.edgeTriangles.resize(noKept);
+		}
+	}
+
+	// The mesh, from the cached meshes of the blocks in hash table order.
+	std::vector<int> triangleOffsets(noBlocks + 1, 0);
+	std::vector<int> vertexOffsets(noBlocks + 1, 0);
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++)
+	{
+		const ITMMeshBlockCache::Block &block = blocks[ptrs[blockIdx]];
+		int noBlockTriangles = static_cast<int>(cache.isIndexed ? block.edgeTriangles.size() : block.triangles.size());
+		triangleOffsets[blockIdx + 1] = triangleOffsets[blockIdx] + noBlockTriangles;
+		vertexOffsets[blockIdx + 1] = vertexOffsets[blockIdx] + static_cast<int>(block.vertices.size());
+	}
+	int noTriangles = triangleOffsets[noBlocks];
+
+	if (!cache.isIndexed)
+	{
+		mesh->Reserve(noTriangles);
+		ITMMesh::Triangle *meshTriangles = mesh->triangles->GetData(MEMORYDEVICE_CPU);
+
+#ifdef WITH_OPENMP
+		#pragma omp parallel for schedule(static)
+#endif
+		for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++)
+		{
+			const std::vector<ITMMesh::Triangle> &triangles = blocks[ptrs[blockIdx]].triangles;
+			std::copy(triangles.begin(), triangles.end(), meshTriangles + triangleOffsets[blockIdx]);
+		}
+
+		mesh->noTotalTriangles = noTriangles;
+		return;
+	}
+
+	std::vector<EdgeVertex> edgeVertices(vertexOffsets[noBlocks]);
+	std::vector<Vector3i> triangles(noTriangles);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++)
+	{
+		const ITMMeshBlockCache::Block &block = blocks[ptrs[blockIdx]];
+		std::copy(block.vertices.begin(), block.vertices.end(), edgeVertices.begin() + vertexOffsets[blockIdx]);
+
+		for (size_t triangleIdx = 0; triangleIdx < block.edgeTriangles.size(); triangleIdx++)
+		{
+			Vector3i &triangle = triangles[triangleOffsets[blockIdx] + triangleIdx];
+			for (int k = 0; k < 3; k++)
+			{
+				int corner = block.edgeTriangles[triangleIdx][k];
+				triangle[k] = vertexOffsets[blockOf[block.neighbourPtrs[corner & 7]]] + ((corner >> 3) & 0x7ff);
+			}
+		}
+	}
+
+	WriteIndexedMesh(mesh, edgeVertices, triangles);
+}
+
+template<class TVoxel, class TIndex>
+static void MeshSceneCached_common(ITMMeshBlockCache &cache, ITMMesh *mesh, const ITMScene<TVoxel, TIndex> *scene)
+{
+	// The cache needs the counts of changes, which are only kept in CPU memory.
+	if (scene->localVBA.GetBlockVersions() == NULL || mesh->memoryType != MEMORYDEVICE_CPU)
+	{
+		MeshScene_common(mesh, scene);
+		return;
+	}
+
+	MeshSceneFromCache_common(cache, mesh, scene);
+
+#ifdef MESH_CACHE_DEBUG
+	ITMMesh fullMesh(MEMORYDEVICE_CPU, scene->localVBA.allocatedSize / SDF_BLOCK_SIZE3, mesh->isIndexed);
+	MeshScene_common(&fullMesh, scene);
+
+	bool isSame = fullMesh.noTotalTriangles == mesh->noTotalTriangles;
+	if (isSame && mesh->isIndexed)
+	{
+		isSame = fullMesh.noTotalVertices == mesh->noTotalVertices &&
+			memcmp(fullMesh.vertices->GetData(MEMORYDEVICE_CPU), mesh->vertices->GetData(MEMORYDEVICE_CPU),
+				mesh->noTotalVertices * sizeof(ITMMesh::Vertex)) == 0 &&
+			memcmp(fullMesh.indices->GetData(MEMORYDEVICE_CPU), mesh->indices->GetData(MEMORYDEVICE_CPU),
+				mesh->noTotalTriangles * 3 * sizeof(uint)) == 0;
+	}
+	else if (isSame)
+	{
+		isSame = memcmp(fullMesh.triangles->GetData(MEMORYDEVICE_CPU), mesh->triangles->GetData(MEMORYDEVICE_CPU),
+			mesh->noTotalTriangles * sizeof(ITMMesh::Triangle)) == 0;
+	}
+	if (!isSame) throw std::runtime_error("The mesh built from the block cache differs from the mesh of the entire scene.");
+#endif
+}
+
+/// \brief Sorts the allocated blocks into chunks of chunkSize^3 blocks, and meshes one chunk after
+///        the other, into a mesh which is reused for all of them. Indexed chunks also list the
+///        neighbours of their blocks in other chunks, for the vertices on their borders.
+template<class TVoxel, class TIndex>
+static void MeshSceneStreamed_common(ITMMeshSink *sink, const ITMScene<TVoxel, TIndex> *scene, bool isIndexed, int chunkSize)
+{
+	if (chunkSize < 1) throw std::runtime_error("The meshing chunk size must be positive.");
+
+	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
+
+	std::vector<Vector3i> blockPositions;
+	std::vector<int> blockPtrs;
+	int noBlocks = GetAllocatedBlocks(scene, blockPositions, blockPtrs);
+
+	auto chunkOf = [=](const Vector3i &position) {
+		Vector3i chunk;
+		for (int axis = 0; axis < 3; axis++) {
+			int blockCoord = position[axis] / SDF_BLOCK_SIZE;
+			chunk[axis] = (blockCoord >= 0 ? blockCoord : blockCoord - chunkSize + 1) / chunkSize;
+		}
+		return chunk;
+	};
+
+	// The blocks ordered by chunk, and within a chunk in hash table order.
+	std::vector<Vector3i> blockChunks(noBlocks);
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++) blockChunks[blockIdx] = chunkOf(blockPositions[blockIdx]);
+	std::vector<int> order(noBlocks);
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++) order[blockIdx] = blockIdx;
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+		const Vector3i &chunkA = blockChunks[a], &chunkB = blockChunks[b];
+		if (chunkA.z != chunkB.z) return chunkA.z < chunkB.z;
+		if (chunkA.y != chunkB.y) return chunkA.y < chunkB.y;
+		return chunkA.x < chunkB.x;
+	});
+
+	ITMMesh chunkMesh(MEMORYDEVICE_CPU, 0, isIndexed);
+	std::vector<int> blockOfPtr;
+	if (isIndexed) blockOfPtr.resize(scene->localVBA.allocatedSize / SDF_BLOCK_SIZE3, -1);
+
+	std::vector<Vector3i> chunkPositions;
+	std::vector<int> chunkPtrs;
+
+	for (int chunkBegin = 0; chunkBegin < noBlocks; )
+	{
+		Vector3i chunk = blockChunks[order[chunkBegin]];
+		int chunkEnd = chunkBegin;
+		while (chunkEnd < noBlocks && blockChunks[order[chunkEnd]] == chunk) chunkEnd++;
+
+		chunkPositions.clear(); chunkPtrs.clear();
+		for (int orderIdx = chunkBegin; orderIdx < chunkEnd; orderIdx++)
+		{
+			chunkPositions.push_back(blockPositions[order[orderIdx]]);
+			chunkPtrs.push_back(blockPtrs[order[orderIdx]]);
+		}
+		int noMeshedBlocks = chunkEnd - chunkBegin;
+
+		if (isIndexed)
+		{
+			for (int blockIdx = 0; blockIdx < noMeshedBlocks; blockIdx++) blockOfPtr[chunkPtrs[blockIdx]] = blockIdx;
+
+			// The neighbours in +x, +y and +z which are in other chunks.
+			for (int blockIdx = 0; blockIdx < noMeshedBlocks; blockIdx++) for (int neighbourIdx = 1; neighbourIdx < 8; neighbourIdx++)
+			{
+				Vector3i offset(neighbourIdx & 1, (neighbourIdx >> 1) & 1, neighbourIdx >> 2);
+				Vector3i neighbourPos = chunkPositions[blockIdx] + offset * SDF_BLOCK_SIZE;
+				bool isFound = false;
+				int voxelIdx = findVoxel(voxelIndex, neighbourPos, isFound);
+				if (!isFound || blockOfPtr[voxelIdx / SDF_BLOCK_SIZE3] >= 0) continue;
+
+				blockOfPtr[voxelIdx / SDF_BLOCK_SIZE3] = static_cast<int>(chunkPositions.size());
+				chunkPositions.push_back(neighbourPos);
+				chunkPtrs.push_back(voxelIdx / SDF_BLOCK_SIZE3);
+			}
+
+			MeshBlocksIndexed_common(&chunkMesh, scene, chunkPositions.data(), noMeshedBlocks,
+				static_cast<int>(chunkPositions.size()), blockOfPtr);
+
+			for (size_t blockIdx = 0; blockIdx < chunkPtrs.size(); blockIdx++) blockOfPtr[chunkPtrs[blockIdx]] = -1;
+		}
+		else MeshBlocks_common(&chunkMesh, scene, chunkPositions.data(), noMeshedBlocks);
+
+		if (chunkMesh.noTotalTriangles > 0) sink->Consume(chunkMesh);
+		chunkBegin = chunkEnd;
+	}
+}
+
 template<class TVoxel>
-ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockHash>::ITMMeshingEngine_CPU(void) 
+ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockHash>::ITMMeshingEngine_CPU(void)
 {
+	blockCache = new ITMMeshBlockCache();
 }
 
 template<class TVoxel>
-ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockHash>::~ITMMeshingEngine_CPU(void) 
+ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockHash>::~ITMMeshingEngine_CPU(void)
 {
+	delete blockCache;
+}
+
+template<class TVoxel>
+void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SetIncrementalMeshing(bool useIncrementalMeshing)
+{
+	this->useIncrementalMeshing = useIncrementalMeshing;
+	if (!useIncrementalMeshing) *blockCache = ITMMeshBlockCache();
 }
 
 template<class TVoxel>
 void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockHash>::MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
 {
-	ITMMesh::Triangle *triangles = mesh->triangles->GetData(MEMORYDEVICE_CPU);
-	const TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
-	const ITMHashEntry *hashTable = scene->index.GetEntries();
+	if (useIncrementalMeshing) MeshSceneCached_common(*blockCache, mesh, scene);
+	else MeshScene_common(mesh, scene);
+}
+
+template<class TVoxel>
+void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockHash>::MeshSceneStreamed(ITMMeshSink *sink,
+	const ITMScene<TVoxel, ITMVoxelBlockHash> *scene, bool isIndexed, int chunkSize)
+{
+	MeshSceneStreamed_common(sink, scene, isIndexed, chunkSize);
+}
 
-	int noTriangles = 0, noMaxTriangles = mesh->noMaxTriangles, noTotalEntries = scene->index.noTotalEntries;
+template<class TVoxel>
+ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::ITMMeshingEngine_CPU(void)
+{
+	blockCache = new ITMMeshBlockCache();
+}
+
+template<class TVoxel>
+ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::~ITMMeshingEngine_CPU(void)
+{
+	delete blockCache;
+}
+
+template<class TVoxel>
+void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::SetIncrementalMeshing(bool useIncrementalMeshing)
+{
+	this->useIncrementalMeshing = useIncrementalMeshing;
+	if (!useIncrementalMeshing) *blockCache = ITMMeshBlockCache();
+}
+
+template<class TVoxel>
+void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene)
+{
+	if (useIncrementalMeshing) MeshSceneCached_common(*blockCache, mesh, scene);
+	else MeshScene_common(mesh, scene);
+}
+
+template<class TVoxel>
+void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::MeshSceneStreamed(ITMMeshSink *sink,
+	const ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene, bool isIndexed, int chunkSize)
+{
+	MeshSceneStreamed_common(sink, scene, isIndexed, chunkSize);
+}
+
+/// \brief Runs marching cubes over a dense volume, and puts the result into the mesh, which can be
+///        indexed or not.
+///
+/// The volume is split into bricks of plainBrickSize planes in z by plainBrickSize rows in y, which
+/// span the volume in x, so that the voxels a brick reads stay in the cache while it is meshed. The
+/// bricks without any observed voxel are skipped, as all the cells which start in them lack a
+/// corner. The others are meshed in parallel, in two passes, like MeshBlocksIndexed_common:
+///  - Every brick creates the vertices on the edges it owns (those which start at one of its
+///    voxels) which the surface crosses, in edge order.
+///  - Every brick meshes its cells, whose corners are looked up in the vertices of the brick, or
+///    of its neighbours in +y and +z. Every vertex is computed once, however many triangles of
+///    either kind of mesh use it.
+/// The result is the same for any number of threads.
+template<class TVoxel>
+static void MeshPlainScene_common(ITMMesh *mesh, const ITMScene<TVoxel, ITMPlainVoxelArray> *scene)
+{
+	const TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	const ITMPlainVoxelArray::IndexData *arrayInfo = scene->index.getIndexData();
+	const Vector3i size = arrayInfo->size, offset = arrayInfo->offset;
 	float factor = scene->sceneParams->voxelSize;
 
-	mesh->triangles->Clear();
+	const int noBricksY = (size.y + plainBrickSize - 1) / plainBrickSize;
+	const int noBricks = noBricksY * ((size.z + plainBrickSize - 1) / plainBrickSize);
+	int maxThreads = GetMaxThreads();
+
+	auto voxelIdx = [=](int x, int y, int z) { return x + (y + z * size.y) * size.x; };
+	// The edges are numbered within the brick of the voxel they start at.
+	auto brickEdgeIdx = [=](int x, int y, int z, int axis) {
+		return ((z % plainBrickSize * plainBrickSize + y % plainBrickSize) * size.x + x) * 3 + axis;
+	};
 
-	for (int entryId = 0; entryId < noTotalEntries; entryId++)
+	// Pass 0: the bricks with observed voxels.
+	std::vector<unsigned char> isBrickObserved(noBricks, 0);
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int brickIdx = 0; brickIdx < noBricks; brickIdx++)
 	{
-		Vector3i globalPos;
-		const ITMHashEntry &currentHashEntry = hashTable[entryId];
+		int y0 = brickIdx % noBricksY * plainBrickSize, z0 = brickIdx / noBricksY * plainBrickSize;
+		int y1 = MIN(y0 + plainBrickSize, size.y), z1 = MIN(z0 + plainBrickSize, size.z);
 
-		if (currentHashEntry.ptr < 0) continue;
+		bool isObserved = false;
+		for (int z = z0; z < z1 && !isObserved; z++) for (int y = y0; y < y1 && !isObserved; y++)
+		{
+			const TVoxel *row = localVBA + voxelIdx(0, y, z);
+			for (int x = 0; x < size.x; x++) isObserved |= row[x].w_depth > 0;
+		}
+		isBrickObserved[brickIdx] = isObserved;
+	}
+
+	std::vector<int> observedBricks(noBricks);
+	int *observed = observedBricks.data();
+	const unsigned char *isObserved = isBrickObserved.data();
+	int noObservedBricks = ORUtils::compactStream(noBricks,
+		[=](int brickIdx) { return isObserved[brickIdx] != 0; },
+		[=](int observedIdx, int brickIdx) { observed[observedIdx] = brickIdx; });
+
+	std::vector<int> observedOfBrick(noBricks, -1);
+	for (int observedIdx = 0; observedIdx < noObservedBricks; observedIdx++) observedOfBrick[observed[observedIdx]] = observedIdx;
+
+	// Pass 1: the vertices of the edges owned by every brick.
+	std::vector<ChunkBuffer<EdgeVertex> > threadVertices(maxThreads);
+	OutputRanges<EdgeVertex> brickVertices(noObservedBricks);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int observedIdx = 0; observedIdx < noObservedBricks; observedIdx++)
+	{
+		int threadId = GetThreadNum();
+		ChunkBuffer<EdgeVertex> &vertices = threadVertices[threadId];
+		brickVertices.Start(observedIdx, threadId, vertices);
 
-		globalPos = currentHashEntry.pos.toInt() * SDF_BLOCK_SIZE;
+		int brickIdx = observed[observedIdx];
+		int y0 = brickIdx % noBricksY * plainBrickSize, z0 = brickIdx / noBricksY * plainBrickSize;
+		int y1 = MIN(y0 + plainBrickSize, size.y), z1 = MIN(z0 + plainBrickSize, size.z);
 
-		for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+		for (int z = z0; z < z1; z++) for (int y = y0; y < y1; y++) for (int x = 0; x < size.x; x++)
 		{
-			Vector3f vertList[12];
-			int cubeIndex = buildVertList(vertList, globalPos, Vector3i(x, y, z), localVBA, hashTable);
-			
-			if (cubeIndex < 0) continue;
+			// Only observed voxels are corners of cells which findPointNeighbors accepts.
+			float sdf0 = TVoxel::SDF_valueToFloat(localVBA[voxelIdx(x, y, z)].sdf);
+			if (sdf0 == 1.0f) continue;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				Vector3i p0(x, y, z), p1(x, y, z);
+				p1[axis]++;
+				if (p1[axis] >= size[axis]) continue;
+
+				float sdf1 = TVoxel::SDF_valueToFloat(localVBA[voxelIdx(p1.x, p1.y, p1.z)].sdf);
+				if (sdf1 == 1.0f || (sdf0 < 0) == (sdf1 < 0)) continue;
+
+				Vector3f point = sdfInterp((p0 + offset).toFloat(), (p1 + offset).toFloat(), sdf0, sdf1);
+				EdgeVertex &edgeVertex = vertices.push_back();
+				edgeVertex.edgeIdx = brickEdgeIdx(x, y, z, axis);
+				edgeVertex.vertex.p = point * factor;
+				edgeVertex.vertex.c = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, ITMPlainVoxelArray>::interpolate3(localVBA,
+					arrayInfo, point);
+			}
+		}
+
+		brickVertices.End(observedIdx, vertices);
+	}
+
+	int noEdgeVertices = brickVertices.Scan();
+	std::vector<EdgeVertex> edgeVertices(noEdgeVertices);
+	brickVertices.Gather(threadVertices, edgeVertices.data());
+	threadVertices.clear();
+
+	// Pass 2: the triangles, as indices into edgeVertices.
+	std::vector<ChunkBuffer<Vector3i> > threadTriangles(maxThreads);
+	OutputRanges<Vector3i> brickTriangles(noObservedBricks);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int observedIdx = 0; observedIdx < noObservedBricks; observedIdx++)
+	{
+		int threadId = GetThreadNum();
+		ChunkBuffer<Vector3i> &triangles = threadTriangles[threadId];
+		brickTriangles.Start(observedIdx, threadId, triangles);
+
+		int brickIdx = observed[observedIdx];
+		int y0 = brickIdx % noBricksY * plainBrickSize, z0 = brickIdx / noBricksY * plainBrickSize;
+		int y1 = MIN(y0 + plainBrickSize, size.y - 1), z1 = MIN(z0 + plainBrickSize, size.z - 1);
+
+		for (int z = z0; z < z1; z++) for (int y = y0; y < y1; y++) for (int x = 0; x < size.x - 1; x++)
+		{
+			// The same cells as buildVertList: all corners observed, and the surface crossing some edge.
+			int cubeIndex = 0;
+			bool isValidCell = true;
+			for (int corner = 0; corner < 8 && isValidCell; corner++)
+			{
+				// The corners in the order of findPointNeighbors.
+				float sdf = TVoxel::SDF_valueToFloat(
+					localVBA[voxelIdx(x + ((corner + 1) >> 1 & 1), y + (corner >> 1 & 1), z + (corner >> 2))].sdf);
+				isValidCell = sdf != 1.0f;
+				if (sdf < 0) cubeIndex |= 1 << corner;
+			}
+			if (!isValidCell || edgeTable[cubeIndex] == 0) continue;
 
 			for (int i = 0; triangleTable[cubeIndex][i] != -1; i += 3)
 			{
-				Vector3f p0 = vertList[triangleTable[cubeIndex][i]];
-				Vector3f p1 = vertList[triangleTable[cubeIndex][i + 1]];
-				Vector3f p2 = vertList[triangleTable[cubeIndex][i + 2]];
-				triangles[noTriangles].p0 = p0 * factor;
-				triangles[noTriangles].p1 = p1 * factor;
-				triangles[noTriangles].p2 = p2 * factor;
-
-				Vector3f c0 =
-						VoxelColorReader<TVoxel::hasColorInformation, TVoxel, ITMVoxelBlockHash>::interpolate3(
-								localVBA,
-								hashTable,
-								p0);
-				Vector3f c1 =
-						VoxelColorReader<TVoxel::hasColorInformation, TVoxel, ITMVoxelBlockHash>::interpolate3(
-								localVBA,
-								hashTable,
-								p1);
-				Vector3f c2 =
-						VoxelColorReader<TVoxel::hasColorInformation, TVoxel, ITMVoxelBlockHash>::interpolate3(
-								localVBA,
-								hashTable,
-								p2);
-
-				triangles[noTriangles].c0 = c0;
-				triangles[noTriangles].c1 = c1;
-				triangles[noTriangles].c2 = c2;
-
-				if (noTriangles < noMaxTriangles - 1) noTriangles++;
+				Vector3i triangle;
+				bool isFound = true;
+				for (int k = 0; k < 3 && isFound; k++)
+				{
+					int edge = triangleTable[cubeIndex][i + k];
+					int ownerX = x + cellEdgeCorners[edge][0], ownerY = y + cellEdgeCorners[edge][1], ownerZ = z + cellEdgeCorners[edge][2];
+					int ownerObservedIdx = observedOfBrick[ownerZ / plainBrickSize * noBricksY + ownerY / plainBrickSize];
+					if (ownerObservedIdx < 0) { isFound = false; break; }
+
+					int begin = brickVertices.offsets[ownerObservedIdx];
+					int vertexIdx = FindEdgeVertex(edgeVertices.data() + begin, edgeVertices.data() + brickVertices.offsets[ownerObservedIdx + 1],
+						brickEdgeIdx(ownerX, ownerY, ownerZ, cellEdgeAxes[edge]));
+					isFound = vertexIdx >= 0;
+					triangle[k] = begin + vertexIdx;
+				}
+				if (isFound) triangles.push_back() = triangle;
 			}
 		}
+
+		brickTriangles.End(observedIdx, triangles);
+	}
+
+	int noTriangles = brickTriangles.Scan();
+	std::vector<Vector3i> triangles(noTriangles);
+	brickTriangles.Gather(threadTriangles, triangles.data());
+	threadTriangles.clear();
+
+	if (mesh->isIndexed)
+	{
+		WriteIndexedMesh(mesh, edgeVertices, triangles);
+		return;
+	}
+
+	mesh->Reserve(noTriangles);
+	ITMMesh::Triangle *meshTriangles = mesh->triangles->GetData(MEMORYDEVICE_CPU);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int triangleIdx = 0; triangleIdx < noTriangles; triangleIdx++)
+	{
+		const ITMMesh::Vertex &v0 = edgeVertices[triangles[triangleIdx].x].vertex;
+		const ITMMesh::Vertex &v1 = edgeVertices[triangles[triangleIdx].y].vertex;
+		const ITMMesh::Vertex &v2 = edgeVertices[triangles[triangleIdx].z].vertex;
+		ITMMesh::Triangle &triangle = meshTriangles[triangleIdx];
+		triangle.p0 = v0.p; triangle.p1 = v1.p; triangle.p2 = v2.p;
+		triangle.c0 = v0.c; triangle.c1 = v1.c; triangle.c2 = v2.c;
 	}
 
 	mesh->noTotalTriangles = noTriangles;
@@ -90,6 +1170,14 @@ ITMMeshingEngine_CPU<TVoxel,ITMPlainVoxelArray>::~ITMMeshingEngine_CPU(void)
 
 template<class TVoxel>
 void ITMMeshingEngine_CPU<TVoxel, ITMPlainVoxelArray>::MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMPlainVoxelArray> *scene)
-{}
+{
+	MeshPlainScene_common(mesh, scene);
+}
 
 template class ITMLib::Engine::ITMMeshingEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+#if ITM_VOXEL_INDEX != ITM_VOXEL_INDEX_OPEN_HASH
+template class ITMLib::Engine::ITMMeshingEngine_CPU<ITMVoxel, ITMVoxelBlockOpenHash>;
+#endif
+#if ITM_VOXEL_INDEX != ITM_VOXEL_INDEX_PLAIN
+template class ITMLib::Engine::ITMMeshingEngine_CPU<ITMVoxel, ITMPlainVoxelArray>;
+#endif
@@ -8,6 +8,9 @@ namespace ITMLib
 {
 	namespace Engine
 	{
+		/// \brief The meshes of the blocks of a hashed scene, as of the last time they were meshed.
+		struct ITMMeshBlockCache;
+
 		template<class TVoxel, class TIndex>
 		class ITMMeshingEngine_CPU : public ITMMeshingEngine < TVoxel, TIndex >
 		{};
@@ -15,9 +18,43 @@ namespace ITMLib
 		template<class TVoxel>
 		class ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockHash> : public ITMMeshingEngine < TVoxel, ITMVoxelBlockHash >
 		{
+		protected:
+			ITMMeshBlockCache *blockCache;
+			bool useIncrementalMeshing = false;
+
 		public:
 			void MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
 
+			void MeshSceneStreamed(ITMMeshSink *sink, const ITMScene<TVoxel, ITMVoxelBlockHash> *scene, bool isIndexed,
+				int chunkSize = 16) override;
+
+			/// \brief Switches between meshing only the blocks which changed since the last call to
+			///        MeshScene, and their neighbours, while reusing the meshes of the others, and
+			///        meshing the entire scene every time (default). The cached meshes take about as
+			///        much memory as the mesh. They are kept for one scene, and only for scenes in CPU
+			///        memory.
+			void SetIncrementalMeshing(bool useIncrementalMeshing) override;
+
+			ITMMeshingEngine_CPU(void);
+			~ITMMeshingEngine_CPU(void);
+		};
+
+		template<class TVoxel>
+		class ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockOpenHash> : public ITMMeshingEngine < TVoxel, ITMVoxelBlockOpenHash >
+		{
+		protected:
+			ITMMeshBlockCache *blockCache;
+			bool useIncrementalMeshing = false;
+
+		public:
+			void MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene);
+
+			void MeshSceneStreamed(ITMMeshSink *sink, const ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene, bool isIndexed,
+				int chunkSize = 16) override;
+
+			/// \brief See ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockHash>.
+			void SetIncrementalMeshing(bool useIncrementalMeshing) override;
+
 			ITMMeshingEngine_CPU(void);
 			~ITMMeshingEngine_CPU(void);
 		};
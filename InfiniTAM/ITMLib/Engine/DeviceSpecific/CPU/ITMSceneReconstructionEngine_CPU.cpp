@@ -1,17 +1,479 @@
 // Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
 
 #include "ITMSceneReconstructionEngine_CPU.h"
+#include "ITMCPUUtils.h"
 #include "../../DeviceAgnostic/ITMSceneReconstructionEngine.h"
 #include "../../../Objects/ITMRenderState_VH.h"
+#include "../../../../ORUtils/StreamCompaction.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
 
 using namespace ITMLib::Engine;
 
+/// \brief Scalar reference integration of a single voxel block, one voxel at a time.
+/// \return Whether any voxel changed.
+template<class TVoxel>
+static bool integrateVoxelBlock_scalar(TVoxel *localVoxelBlock, const Vector3i &globalPos, const Matrix4f &M_d,
+	const Vector4f &projParams_d, const Matrix4f &M_rgb, const Vector4f &projParams_rgb, float voxelSize, float mu, int maxW,
+	bool stopIntegratingAtMaxW, const float *depth, const Vector2i &depthImgSize, const Vector4u *rgb,
+	const Vector2i &rgbImgSize, const WeightParams &weightParams)
+{
+	bool isChanged = false;
+
+	for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+	{
+		Vector4f pt_model; int locId;
+
+		locId = voxelBlockLocalIdx(x, y, z);
+
+		if (stopIntegratingAtMaxW) if (localVoxelBlock[locId].w_depth == maxW) continue;
+
+		pt_model.x = (float)(globalPos.x + x) * voxelSize;
+		pt_model.y = (float)(globalPos.y + y) * voxelSize;
+		pt_model.z = (float)(globalPos.z + z) * voxelSize;
+		pt_model.w = 1.0f;
+
+		TVoxel oldVoxel = localVoxelBlock[locId];
+		ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation, TVoxel>::compute(localVoxelBlock[locId], pt_model, M_d,
+			projParams_d, M_rgb, projParams_rgb, mu, maxW, depth, depthImgSize, rgb, rgbImgSize, weightParams);
+		isChanged |= memcmp(&oldVoxel, &localVoxelBlock[locId], sizeof(TVoxel)) != 0;
+	}
+
+	return isChanged;
+}
+
+/// \brief Integrates a single voxel block in three passes, so that the projection and depth lookup
+///        of all 512 voxels can be vectorised by the compiler.
+///
+/// The first pass projects the voxels and gathers the depth measurements into flat buffers, the
+/// second blends the SDF values and the weights, and the third fuses the colour of the voxels
+/// close to the surface. The arithmetic mirrors 'computeUpdatedVoxelDepthInfo' operation by
+/// operation, so the output matches the scalar path for both the short and the float SDF encodings.
+/// \return Whether any voxel was updated. The colour is only updated along with the depth.
+template<class TVoxel>
+static bool integrateVoxelBlock_vectorised(TVoxel *localVoxelBlock, const Vector3i &globalPos, const Matrix4f &M_d,
+	const Vector4f &projParams_d, const Matrix4f &M_rgb, const Vector4f &projParams_rgb, float voxelSize, float mu, int maxW,
+	bool stopIntegratingAtMaxW, const float *depth, const Vector2i &depthImgSize, const Vector4u *rgb,
+	const Vector2i &rgbImgSize, const WeightParams &weightParams)
+{
+	// -1 marks voxels which were not updated, just like the return value of the scalar code.
+	float etaBuffer[SDF_BLOCK_SIZE3];
+	float depthBuffer[SDF_BLOCK_SIZE3];
+
+	const float *m = M_d.m;
+	const float maxX = (float)(depthImgSize.x - 2), maxY = (float)(depthImgSize.y - 2);
+
+#ifdef WITH_OPENMP
+	#pragma omp simd
+#endif
+	for (int locId = 0; locId < SDF_BLOCK_SIZE3; locId++)
+	{
+		Vector3i locPos = voxelBlockLocalPos(locId);
+
+		float px = (float)(globalPos.x + locPos.x) * voxelSize;
+		float py = (float)(globalPos.y + locPos.y) * voxelSize;
+		float pz = (float)(globalPos.z + locPos.z) * voxelSize;
+
+		float cx = m[0] * px + m[4] * py + m[8] * pz + m[12] * 1.0f;
+		float cy = m[1] * px + m[5] * py + m[9] * pz + m[13] * 1.0f;
+		float cz = m[2] * px + m[6] * py + m[10] * pz + m[14] * 1.0f;
+
+		bool inFront = cz > 0;
+		float safeZ = inFront ? cz : 1.0f;
+		float ix = projParams_d.x * cx / safeZ + projParams_d.z;
+		float iy = projParams_d.y * cy / safeZ + projParams_d.w;
+		bool inImage = inFront && ix >= 1 && ix <= maxX && iy >= 1 && iy <= maxY;
+
+		int depthIdx = inImage ? (int)(ix + 0.5f) + (int)(iy + 0.5f) * depthImgSize.x : 0;
+		float depthMeasure = inImage ? depth[depthIdx] : -1.0f;
+
+		depthBuffer[locId] = depthMeasure;
+		etaBuffer[locId] = depthMeasure > 0.0f ? depthMeasure - cz : -1.0f;
+	}
+
+	bool isUpdated = false;
+	for (int locId = 0; locId < SDF_BLOCK_SIZE3; locId++)
+	{
+		TVoxel &voxel = localVoxelBlock[locId];
+		float eta = etaBuffer[locId];
+		float depthMeasure = depthBuffer[locId];
+
+		if (stopIntegratingAtMaxW && voxel.w_depth == maxW) { etaBuffer[locId] = -1.0f; continue; }
+		if (depthMeasure <= 0.0f || eta < -mu) continue;
+		isUpdated = true;
+
+		float oldF = TVoxel::SDF_valueToFloat(voxel.sdf);
+		int oldW = voxel.w_depth;
+		float newF = MIN(1.0f, eta / mu);
+		int newW = 1;
+
+		if (weightParams.depthWeighting) {
+			newW = (int)(100.0 / depthMeasure);
+			if (newW < 1) newW = 1;
+			if (newW > 10) newW = 10;
+		}
+
+		newF = oldW * oldF + newW * newF;
+		newW = oldW + newW;
+		newF /= newW;
+		newW = MIN(newW, maxW);
+
+		voxel.sdf = TVoxel::SDF_floatToValue(newF);
+		voxel.w_depth = newW;
+	}
+
+	if (!TVoxel::hasColorInformation || !isUpdated) return isUpdated;
+
+	// Colour is only fused close to the surface, exactly like in 'ComputeUpdatedVoxelInfo'.
+	for (int locId = 0; locId < SDF_BLOCK_SIZE3; locId++)
+	{
+		float eta = etaBuffer[locId];
+		if ((eta > mu) || (fabs(eta / mu) > 0.25f)) continue;
+
+		Vector3i locPos = voxelBlockLocalPos(locId);
+		Vector4f pt_model;
+		pt_model.x = (float)(globalPos.x + locPos.x) * voxelSize;
+		pt_model.y = (float)(globalPos.y + locPos.y) * voxelSize;
+		pt_model.z = (float)(globalPos.z + locPos.z) * voxelSize;
+		pt_model.w = 1.0f;
+
+		ComputeUpdatedVoxelColorInfo<TVoxel::hasColorInformation, TVoxel>::compute(localVoxelBlock[locId], pt_model,
+			M_rgb, projParams_rgb, mu, maxW, eta, rgb, rgbImgSize);
+	}
+
+	return true;
+}
+
+/// \brief Deletes a block from the hash table and de-allocates its VBA entry.
+///
+/// The VBA slot goes back to the voxel allocation list, and if the deletion frees up a slot in the
+/// excess list, that slot is handed back to the excess allocation list as well.
+///
+/// \note The caller must hold the lock of the block's bucket. Does not support swapping.
+static void deleteBlock_CPU(
+		ITMHashEntry *hashTable,
+		int bucketNum,
+		int hashIdx,
+		int prevHashIdx,
+		int *voxelAllocationList,
+		int *lastFreeBlockId,
+		int *excessAllocationList,
+		int *lastFreeExcessListId,
+		uchar *entriesVisibleType
+) {
+	// First, deallocate the VBA slot.
+	int freeListIdx = atomicAdd_CPU(lastFreeBlockId, 1);
+	voxelAllocationList[freeListIdx + 1] = hashTable[hashIdx].ptr;
+
+	// Second, clear out the hash table entry, and do bookkeeping for buckets with more than one element.
+	int freedExcessIdx = -1;
+	if (prevHashIdx == -1) {
+		if (hashTable[hashIdx].offset >= 1) {
+			// In the ordered list, with a successor, which gets moved into the bucket.
+			int nextIdx = bucketNum + hashTable[hashIdx].offset - 1;
+			hashTable[hashIdx] = hashTable[nextIdx];
+
+			entriesVisibleType[hashIdx] = entriesVisibleType[nextIdx];
+			entriesVisibleType[nextIdx] = 0;
+
+			hashTable[nextIdx].offset = 0;
+			hashTable[nextIdx].ptr = -2;
+			freedExcessIdx = nextIdx - bucketNum;
+		}
+		else {
+			// In the ordered list, and no successor.
+			hashTable[hashIdx].ptr = -2;
+			entriesVisibleType[hashIdx] = 0;
+		}
+	}
+	else {
+		// In the excess list with a successor or not.
+		hashTable[prevHashIdx].offset = hashTable[hashIdx].offset;
+		hashTable[hashIdx].offset = 0;
+		hashTable[hashIdx].ptr = -2;
+
+		entriesVisibleType[hashIdx] = 0;
+		freedExcessIdx = hashIdx - bucketNum;
+	}
+
+	if (freedExcessIdx >= 0) {
+		int excessListIdx = atomicAdd_CPU(lastFreeExcessListId, 1);
+		excessAllocationList[excessListIdx + 1] = freedExcessIdx;
+	}
+}
+
+/// \brief Counts a block which was added to (delta = 1) or deleted from (delta = -1) a hash table in
+///        the occupancy grid of the table, if it has one.
+static void updateBlockOccupancy_CPU(const ITMVoxelBlockHash::IndexData *voxelIndex, const Vector3i &blockPos, int delta)
+{
+	if (voxelIndex->brickOccupancy == NULL) return;
+
+	int brickIdx, sectorIdx;
+	blockOccupancyIdx(blockPos, brickIdx, sectorIdx);
+
+	atomicAdd_CPU(&voxelIndex->brickOccupancy[brickIdx], delta);
+	atomicAdd_CPU(&voxelIndex->sectorOccupancy[sectorIdx], delta);
+}
+
+/// \brief Decays the voxels of a single block, and deletes the block if it ends up empty.
+///
+/// Unlike the CUDA version, which spreads a block over 512 threads and skips contended buckets,
+/// one thread handles the entire block while holding the lock of its bucket. This keeps the hash
+/// chain stable while the block is being looked up and possibly deleted.
+template<class TVoxel>
+static void decayBlock_CPU(
+		const Vector3i &blockPos,
+		ITMLocalVBA<TVoxel> &localVBA,
+		const ITMVoxelBlockHash::IndexData *voxelIndex,
+		int minAge,
+		int maxWeight,
+		int *voxelAllocationList,
+		int *lastFreeBlockId,
+		int *excessAllocationList,
+		int *lastFreeExcessListId,
+		int *locks,
+		int currentFrame,
+		uchar *entriesVisibleType
+) {
+	ITMHashEntry *hashTable = voxelIndex->entries;
+	int keyHash = hashIndex(blockPos, voxelIndex->hashMask);
+	while (exchangeBucketLock(locks, keyHash, BUCKET_LOCKED) == BUCKET_LOCKED) { }
+
+	bool isFound = false;
+	int blockHashIdx = -1;
+	int blockPrevHashIdx = -1;
+	findVoxel(voxelIndex, blockPos, 0, isFound, blockHashIdx, blockPrevHashIdx);
+
+	// The block was already de-allocated, or it is too young to be decayed. The latter also covers
+	// blocks which got deleted and then reallocated since they were put in the visible list.
+	if (!isFound || currentFrame - hashTable[blockHashIdx].allocatedTime < minAge) {
+		exchangeBucketLock(locks, keyHash, BUCKET_UNLOCKED);
+		return;
+	}
+
+	int blockOffset = hashTable[blockHashIdx].ptr * SDF_BLOCK_SIZE3;
+	TVoxel *localVoxelBlock = localVBA.GetVoxelBlocks() + blockOffset;
+	int emptyVoxels = 0;
+	bool isChanged = false;
+	for (int locId = 0; locId < SDF_BLOCK_SIZE3; locId++)
+	{
+		TVoxel &voxel = localVoxelBlock[locId];
+		bool isNoisy = (voxel.w_depth <= maxWeight);
+		if (isNoisy && voxel.w_depth > 0) {
+			voxel.reset();
+			isChanged = true;
+		}
+
+		if (voxel.w_depth == 0) {
+			emptyVoxels++;
+		}
+	}
+	// Blocks which survive the decay unchanged do not have to be meshed again.
+	if (isChanged) localVBA.VoxelsChanged(blockOffset, SDF_BLOCK_SIZE3);
+
+	if (emptyVoxels == SDF_BLOCK_SIZE3) {
+		updateBlockOccupancy_CPU(voxelIndex, blockPos, -1);
+		deleteBlock_CPU(hashTable, voxelIndex->bucketNum, blockHashIdx, blockPrevHashIdx, voxelAllocationList, lastFreeBlockId,
+						excessAllocationList, lastFreeExcessListId, entriesVisibleType);
+	}
+
+	exchangeBucketLock(locks, keyHash, BUCKET_UNLOCKED);
+}
+
+/// \brief Inserts an entry into a hash table, appending it to its bucket's chain in the excess list
+///        if the bucket is taken. Not thread-safe.
+/// \return False if the excess list is full.
+static bool insertHashEntry_CPU(
+		ITMHashEntry *hashTable,
+		int bucketNum,
+		const int *excessAllocationList,
+		int &lastFreeExcessListId,
+		ITMHashEntry hashEntry
+) {
+	int hashIdx = hashIndex(hashEntry.pos, bucketNum - 1);
+	hashEntry.offset = 0;
+
+	if (hashTable[hashIdx].ptr < -1) {
+		hashTable[hashIdx] = hashEntry;
+		return true;
+	}
+
+	while (hashTable[hashIdx].offset >= 1) hashIdx = bucketNum + hashTable[hashIdx].offset - 1;
+
+	if (lastFreeExcessListId < 0) return false;
+
+	int exlOffset = excessAllocationList[lastFreeExcessListId--];
+	hashTable[bucketNum + exlOffset] = hashEntry;
+	hashTable[hashIdx].offset = exlOffset + 1;
+	return true;
+}
+
+/// \brief Moves the blocks of the next (at most) maxBuckets buckets of the previous table of a
+///        growing hash table into the current one, and releases the previous table once all of
+///        its buckets have been processed.
+static void migrateHashBuckets_CPU(ITMVoxelBlockHash &index, int maxBuckets)
+{
+	ITMHashEntry *oldHashTable = index.GetOldEntries();
+	ITMHashEntry *hashTable = index.GetEntries();
+	const int *excessAllocationList = index.GetExcessAllocationList();
+	int oldBucketNum = index.getOldBucketNum();
+	int bucketNum = index.getBucketNum();
+	int lastFreeExcessListId = index.GetLastFreeExcessListId();
+
+	int firstBucket = index.GetNextMigratedBucket();
+	int lastBucket = std::min(oldBucketNum, firstBucket + maxBuckets);
+
+	for (int bucketIdx = firstBucket; bucketIdx < lastBucket; bucketIdx++)
+	{
+		int hashIdx = bucketIdx;
+		while (true)
+		{
+			ITMHashEntry &oldEntry = oldHashTable[hashIdx];
+			int offset = oldEntry.offset;
+
+			// Entries which have been moved on demand are already marked as free.
+			if (oldEntry.ptr >= 0 && !insertHashEntry_CPU(hashTable, bucketNum, excessAllocationList,
+														  lastFreeExcessListId, oldEntry)) {
+				throw std::runtime_error("Ran out of excess list slots while growing the hash table.");
+			}
+
+			oldEntry.ptr = -2;
+			oldEntry.offset = 0;
+
+			if (offset < 1) break;
+			hashIdx = oldBucketNum + offset - 1;
+		}
+	}
+
+	index.SetLastFreeExcessListId(lastFreeExcessListId);
+	index.SetNextMigratedBucket(lastBucket);
+
+	if (lastBucket == oldBucketNum) {
+		index.FinishGrowth();
+	}
+}
+
+/// \brief Morton code of a block position: the bits of the three (offset) coordinates, interleaved.
+static inline unsigned long long blockMortonCode(const Vector4s &blockPos)
+{
+	auto spreadBits = [](unsigned long long v) {
+		v = (v | (v << 32)) & 0x001f00000000ffffULL;
+		v = (v | (v << 16)) & 0x001f0000ff0000ffULL;
+		v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+		v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+		v = (v | (v << 2)) & 0x1249249249249249ULL;
+		return v;
+	};
+
+	return spreadBits((unsigned short)(blockPos.x + 0x8000)) | (spreadBits((unsigned short)(blockPos.y + 0x8000)) << 1) |
+		   (spreadBits((unsigned short)(blockPos.z + 0x8000)) << 2);
+}
+
+/// \brief Decides which free VBA slot each of this frame's allocation requests gets.
+///
+/// The requests are ranked by the Morton code of the requested block, and the slots at the top of
+/// the voxel allocation list which the requests are going to take are sorted, so that the request
+/// with rank k takes the k-th lowest of those slots: 'voxelAllocationList[lastFreeVoxelBlockId - k]'.
+/// Blocks allocated together which are spatial neighbours thus end up next to each other in the
+/// VBA, instead of being scattered in hash table order.
+///
+/// \param allocationRanks Receives the rank of every request, indexed by its hash entry.
+/// \return The number of requests.
+static int rankAllocationRequests_CPU(const uchar *entriesAllocType, const Vector4s *blockCoords, int noTotalEntries,
+	int *voxelAllocationList, int lastFreeVoxelBlockId, int *allocationRanks)
+{
+	// The entry IDs of the requests are compacted into allocationRanks first. They are all copied
+	// out before any rank is written.
+	int noRequests = ORUtils::compactIndices(noTotalEntries,
+		[=](int targetIdx) { return entriesAllocType[targetIdx] != 0; }, allocationRanks);
+	if (noRequests == 0) return 0;
+
+	std::vector<std::pair<unsigned long long, int> > requests(noRequests);
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int requestIdx = 0; requestIdx < noRequests; requestIdx++)
+	{
+		int targetIdx = allocationRanks[requestIdx];
+		requests[requestIdx] = std::make_pair(blockMortonCode(blockCoords[targetIdx]), targetIdx);
+	}
+	std::sort(requests.begin(), requests.end());
+
+	for (int rank = 0; rank < noRequests; rank++) allocationRanks[requests[rank].second] = rank;
+
+	int noTakenSlots = std::min(noRequests, lastFreeVoxelBlockId + 1);
+	std::sort(voxelAllocationList + lastFreeVoxelBlockId - noTakenSlots + 1, voxelAllocationList + lastFreeVoxelBlockId + 1,
+			  std::greater<int>());
+
+	return noRequests;
+}
+
 template<class TVoxel>
-ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ITMSceneReconstructionEngine_CPU(void) 
+ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ITMSceneReconstructionEngine_CPU(int sdfBucketNum, int sdfExcessListSize)
+	: sdfBucketNum(sdfBucketNum), sdfExcessListSize(sdfExcessListSize)
 {
-	int noTotalEntries = ITMVoxelBlockHash::noTotalEntries;
+	int noTotalEntries = sdfBucketNum + sdfExcessListSize;
 	entriesAllocType = new ORUtils::MemoryBlock<unsigned char>(noTotalEntries, MEMORYDEVICE_CPU);
 	blockCoords = new ORUtils::MemoryBlock<Vector4s>(noTotalEntries, MEMORYDEVICE_CPU);
+	allocationRanks = new ORUtils::MemoryBlock<int>(noTotalEntries, MEMORYDEVICE_CPU);
+	locks = new ORUtils::MemoryBlock<int>(sdfBucketNum, MEMORYDEVICE_CPU);
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::FitBuffersToTable(const ITMVoxelBlockHash &index)
+{
+	if (index.getBucketNum() == sdfBucketNum && index.getExcessListSize() == sdfExcessListSize) return;
+
+	sdfBucketNum = index.getBucketNum();
+	sdfExcessListSize = index.getExcessListSize();
+
+	delete entriesAllocType;
+	delete blockCoords;
+	delete allocationRanks;
+	delete locks;
+	entriesAllocType = new ORUtils::MemoryBlock<unsigned char>(index.noTotalEntries, MEMORYDEVICE_CPU);
+	blockCoords = new ORUtils::MemoryBlock<Vector4s>(index.noTotalEntries, MEMORYDEVICE_CPU);
+	allocationRanks = new ORUtils::MemoryBlock<int>(index.noTotalEntries, MEMORYDEVICE_CPU);
+	locks = new ORUtils::MemoryBlock<int>(sdfBucketNum, MEMORYDEVICE_CPU);
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::UpdateHashTableGrowth(ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	HashGrowthParams params = this->GetHashGrowthParams();
+	ITMVoxelBlockHash &index = scene->index;
+
+	if (!params.enabled || scene->useSwapping) return;
+
+	long usedBlocks = scene->index.getNumAllocatedVoxelBlocks() - scene->localVBA.lastFreeBlockId - 1;
+	auto isTableFull = [&]() {
+		long usedExcessEntries = index.getExcessListSize() - index.GetLastFreeExcessListId() - 1;
+		return usedExcessEntries > params.maxExcessListUsage * index.getExcessListSize() ||
+			   usedBlocks > params.maxLoadFactor * index.getBucketNum();
+	};
+
+	// The scene grew faster than the blocks could be migrated. The table can only grow again
+	// once the migration is complete, so it is completed right away.
+	if (index.IsGrowing() && isTableFull()) {
+		migrateHashBuckets_CPU(index, index.getOldBucketNum());
+	}
+
+	if (!index.IsGrowing() && isTableFull())
+	{
+		// Leave room for the blocks which get allocated while the migration is running.
+		int newBucketNum = 2 * index.getBucketNum(), newExcessListSize = 2 * index.getExcessListSize();
+		while (usedBlocks > 0.5f * params.maxLoadFactor * newBucketNum) {
+			newBucketNum *= 2;
+			newExcessListSize *= 2;
+		}
+
+		index.BeginGrowth(newBucketNum, newExcessListSize);
+	}
+
+	if (index.IsGrowing()) migrateHashBuckets_CPU(index, params.bucketsMigratedPerFrame);
 }
 
 template<class TVoxel>
@@ -19,6 +481,14 @@ ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::~ITMSceneReconstruct
 {
 	delete entriesAllocType;
 	delete blockCoords;
+	delete allocationRanks;
+	delete locks;
+	delete allocatedBlockPositions;
+
+	while (! frameVisibleBlocks.empty()) {
+		delete frameVisibleBlocks.front().blockCoords;
+		frameVisibleBlocks.pop();
+	}
 }
 
 template<class TVoxel>
@@ -27,92 +497,141 @@ void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ResetScene(ITMS
 	int numBlocks = scene->index.getNumAllocatedVoxelBlocks();
 	int blockSize = scene->index.getVoxelBlockSize();
 
+	totalDecayedBlockCount = 0;
+	// Clean up the visible frame queue used in voxel decay.
+	while (! frameVisibleBlocks.empty()) {
+		delete frameVisibleBlocks.front().blockCoords;
+		frameVisibleBlocks.pop();
+	}
+
 	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
 	for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
+	scene->localVBA.VoxelsChanged(0, numBlocks * blockSize);
 	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
 	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
 	scene->localVBA.lastFreeBlockId = numBlocks - 1;
 
+	// A table which was growing keeps its new size, and the blocks still to be migrated are dropped.
+	if (scene->index.IsGrowing()) scene->index.FinishGrowth();
+
 	ITMHashEntry tmpEntry;
 	memset(&tmpEntry, 0, sizeof(ITMHashEntry));
 	tmpEntry.ptr = -2;
 	ITMHashEntry *hashEntry_ptr = scene->index.GetEntries();
 	for (int i = 0; i < scene->index.noTotalEntries; ++i) hashEntry_ptr[i] = tmpEntry;
+	scene->index.SetOccupancyGrid(this->GetOccupancyGrid());
+	scene->index.ClearOccupancy();
+	int excessListSize = scene->index.getExcessListSize();
 	int *excessList_ptr = scene->index.GetExcessAllocationList();
-	for (int i = 0; i < SDF_EXCESS_LIST_SIZE; ++i) excessList_ptr[i] = i;
+	for (int i = 0; i < excessListSize; ++i) excessList_ptr[i] = i;
 
-	scene->index.SetLastFreeExcessListId(SDF_EXCESS_LIST_SIZE - 1);
+	scene->index.SetLastFreeExcessListId(excessListSize - 1);
 }
 
+/// \brief Integrates one view into the blocks of a hashed scene, one block at a time.
 template<class TVoxel>
-void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMView *view,
-	const ITMTrackingState *trackingState, const ITMRenderState *renderState)
+class BlockIntegrator_CPU
 {
-	Vector2i rgbImgSize = view->rgb->noDims;
-	Vector2i depthImgSize = view->depth->noDims;
-	float voxelSize = scene->sceneParams->voxelSize;
-
+private:
+	ITMLocalVBA<TVoxel> *localVBA;
 	Matrix4f M_d, M_rgb;
 	Vector4f projParams_d, projParams_rgb;
+	float voxelSize, mu;
+	int maxW;
+	bool stopIntegratingAtMaxW, useVectorisedIntegration;
+	const float *depth;
+	const Vector4u *rgb;
+	Vector2i depthImgSize, rgbImgSize;
+	WeightParams fusionWeightParams;
+
+public:
+	template<class TIndex>
+	BlockIntegrator_CPU(ITMScene<TVoxel, TIndex> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+		bool useVectorisedIntegration, const WeightParams &fusionWeightParams)
+		: localVBA(&scene->localVBA), useVectorisedIntegration(useVectorisedIntegration), fusionWeightParams(fusionWeightParams)
+	{
+		M_d = trackingState->pose_d->GetM();
+		if (TVoxel::hasColorInformation) M_rgb = view->calib->trafo_rgb_to_depth.calib_inv * M_d;
 
-	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
-
-	M_d = trackingState->pose_d->GetM();
-	if (TVoxel::hasColorInformation) M_rgb = view->calib->trafo_rgb_to_depth.calib_inv * M_d;
-
-	projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
-	projParams_rgb = view->calib->intrinsics_rgb.projectionParamsSimple.all;
-
-	float mu = scene->sceneParams->mu; int maxW = scene->sceneParams->maxW;
-
-	float *depth = view->depth->GetData(MEMORYDEVICE_CPU);
-	Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CPU);
-	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
-	ITMHashEntry *hashTable = scene->index.GetEntries();
+		projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
+		projParams_rgb = view->calib->intrinsics_rgb.projectionParamsSimple.all;
 
-	/*
-	int *visibleEntryIds = renderState_vh->GetVisibleEntryIDs();
-	int noVisibleEntries = renderState_vh->noVisibleEntries;
+		voxelSize = scene->sceneParams->voxelSize;
+		mu = scene->sceneParams->mu;
+		maxW = scene->sceneParams->maxW;
+		stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
 
-	bool stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
-	//bool approximateIntegration = !trackingState->requiresFullRendering;
+		depth = view->depth->GetData(MEMORYDEVICE_CPU);
+		rgb = view->rgb->GetData(MEMORYDEVICE_CPU);
+		depthImgSize = view->depth->noDims;
+		rgbImgSize = view->rgb->noDims;
+	}
 
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int entryId = 0; entryId < noVisibleEntries; entryId++)
+	/// \brief Integrates the view into the block of a hash entry. Blocks can be integrated in parallel.
+	void IntegrateBlock(const ITMHashEntry &hashEntry) const
 	{
-		Vector3i globalPos;
-		const ITMHashEntry &currentHashEntry = hashTable[visibleEntryIds[entryId]];
+		if (hashEntry.ptr < 0) return;
 
-		if (currentHashEntry.ptr < 0) continue;
+		Vector3i globalPos = hashEntry.pos.toInt() * SDF_BLOCK_SIZE;
+		TVoxel *localVoxelBlock = localVBA->GetVoxelBlocks() + hashEntry.ptr * SDF_BLOCK_SIZE3;
 
-		globalPos.x = currentHashEntry.pos.x;
-		globalPos.y = currentHashEntry.pos.y;
-		globalPos.z = currentHashEntry.pos.z;
-		globalPos *= SDF_BLOCK_SIZE;
+		bool isChanged;
+		if (useVectorisedIntegration) {
+			isChanged = integrateVoxelBlock_vectorised(localVoxelBlock, globalPos, M_d, projParams_d, M_rgb, projParams_rgb, voxelSize,
+				mu, maxW, stopIntegratingAtMaxW, depth, depthImgSize, rgb, rgbImgSize, fusionWeightParams);
+		}
+		else {
+			isChanged = integrateVoxelBlock_scalar(localVoxelBlock, globalPos, M_d, projParams_d, M_rgb, projParams_rgb, voxelSize,
+				mu, maxW, stopIntegratingAtMaxW, depth, depthImgSize, rgb, rgbImgSize, fusionWeightParams);
+		}
 
-		TVoxel *localVoxelBlock = &(localVBA[currentHashEntry.ptr * (SDF_BLOCK_SIZE3)]);
+		// Most visible blocks are far from any measurement, and do not have to be meshed again.
+		if (isChanged) localVBA->VoxelsChanged(hashEntry.ptr * SDF_BLOCK_SIZE3, SDF_BLOCK_SIZE3);
+	}
+};
+
+/// \brief Integrates the current view into the visible blocks of a hashed scene, for any index
+///        which stores ITMHashEntry elements.
+template<class TVoxel, class TIndex>
+static void IntegrateIntoScene_common(ITMScene<TVoxel, TIndex> *scene, const ITMView *view,
+	const ITMTrackingState *trackingState, const ITMRenderState *renderState, bool useVectorisedIntegration,
+	const WeightParams &fusionWeightParams)
+{
+	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+	if (renderState_vh->noVisibleBlocks == 0) {
+		// Nothing was allocated or seen from this view, so there is nothing to integrate.
+		return;
+	}
 
-		for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
-		{
-			Vector4f pt_model; int locId;
+	BlockIntegrator_CPU<TVoxel> integrator(scene, view, trackingState, useVectorisedIntegration, fusionWeightParams);
+	const ITMHashEntry *hashTable = scene->index.GetEntries();
+	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
 
-			locId = x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+	const Vector3i *visibleBlockPositions = renderState_vh->GetVisibleBlockPositions();
+	int noVisibleBlocks = renderState_vh->noVisibleBlocks;
 
-			if (stopIntegratingAtMaxW) if (localVoxelBlock[locId].w_depth == maxW) continue;
-			//if (approximateIntegration) if (localVoxelBlock[locId].w_depth != 0) continue;
+	// Blocks close to the camera project onto more pixels and are therefore not equally expensive,
+	// so the visible list is handed out dynamically.
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, 8)
+#endif
+	for (int visibleIdx = 0; visibleIdx < noVisibleBlocks; visibleIdx++)
+	{
+		bool isFound = false;
+		int entryId = findBlock(voxelIndex, visibleBlockPositions[visibleIdx], isFound);
 
-			pt_model.x = (float)(globalPos.x + x) * voxelSize;
-			pt_model.y = (float)(globalPos.y + y) * voxelSize;
-			pt_model.z = (float)(globalPos.z + z) * voxelSize;
-			pt_model.w = 1.0f;
+		// The block may have been lost, e.g., when resetting the volume of an object instance.
+		if (!isFound || entryId < 0) continue;
 
-			ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation,TVoxel>::compute(localVoxelBlock[locId], pt_model, M_d, 
-				projParams_d, M_rgb, projParams_rgb, mu, maxW, depth, depthImgSize, rgb, rgbImgSize);
-		}
+		integrator.IntegrateBlock(hashTable[entryId]);
 	}
-	 //*/
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMView *view,
+	const ITMTrackingState *trackingState, const ITMRenderState *renderState)
+{
+	IntegrateIntoScene_common(scene, view, trackingState, renderState, useVectorisedIntegration, this->GetFusionWeightParams());
 }
 
 template<class TVoxel>
@@ -127,6 +646,12 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 
 	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
 
+	// Grow the hash table or continue migrating its blocks, if necessary. Done before anything
+	// else, since it can change the entry IDs.
+	UpdateHashTableGrowth(scene);
+	FitBuffersToTable(scene->index);
+	renderState_vh->ResizeEntriesVisibleType(scene->index.noTotalEntries);
+
 	M_d = trackingState->pose_d->GetM(); M_d.inv(invM_d);
 
 	projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
@@ -140,13 +665,17 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 	int *voxelAllocationList = scene->localVBA.GetAllocationList();
 	int *excessAllocationList = scene->index.GetExcessAllocationList();
 	ITMHashEntry *hashTable = scene->index.GetEntries();
-  /*
+	const ITMVoxelBlockHash::IndexData *voxelIndex = scene->index.getIndexData();
 	ITMHashSwapState *swapStates = scene->useSwapping ? scene->globalCache->GetSwapStates(false) : 0;
-	int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
+	Vector3i *visibleBlockPositions = renderState_vh->GetVisibleBlockPositions();
 	uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
 	uchar *entriesAllocType = this->entriesAllocType->GetData(MEMORYDEVICE_CPU);
 	Vector4s *blockCoords = this->blockCoords->GetData(MEMORYDEVICE_CPU);
+	int *locks = this->locks->GetData(MEMORYDEVICE_CPU);
 	int noTotalEntries = scene->index.noTotalEntries;
+	int bucketNum = scene->index.getBucketNum();
+	int noPreviouslyVisibleBlocks = renderState_vh->noVisibleBlocks;
+	int currentFrame = static_cast<int>(frameIdx);
 
 	bool useSwapping = scene->useSwapping;
 
@@ -155,43 +684,119 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 	int lastFreeVoxelBlockId = scene->localVBA.lastFreeBlockId;
 	int lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
 
-	int noVisibleEntries = 0;
-
 	memset(entriesAllocType, 0, noTotalEntries);
+	memset(locks, 0, sizeof(int) * bucketNum);
 
-	for (int i = 0; i < renderState_vh->noVisibleEntries; i++)
-		entriesVisibleType[visibleEntryIDs[i]] = 3; // visible at previous frame and unstreamed
-
-	//build hashVisibility
+	// Flag the blocks which were visible in the previous frame (type 3), so they can be re-checked
+	// against the current pose when building the visible list.
 #ifdef WITH_OPENMP
 	#pragma omp parallel for
 #endif
-	for (int locId = 0; locId < depthImgSize.x*depthImgSize.y; locId++)
+	for (int visibleIdx = 0; visibleIdx < noPreviouslyVisibleBlocks; visibleIdx++)
 	{
-		int y = locId / depthImgSize.x;
-		int x = locId - y * depthImgSize.x;
+		bool isFound = false;
+		int hashIdx = findBlock(voxelIndex, visibleBlockPositions[visibleIdx], isFound);
 
-		// Note: this call and all the stuff surrounding were disabled when voxel decay support was
-		// added to DynSLAM. This code would require to be brought up to date to e.g., support
-		// bucket locking, etc. before it can work in the DynSLAM context.
-		buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
-			invProjParams_d, mu, depthImgSize, oneOverVoxelSize, hashTable, scene->sceneParams->viewFrustum_min,
-			scene->sceneParams->viewFrustum_max, 0);	// TODO: remove the 0 or pass in real array
+		// The block may have been removed by the decay in the meantime, which is not an error.
+		if (isFound && hashIdx >= 0) entriesVisibleType[hashIdx] = 3;
 	}
 
-	if (onlyUpdateVisibleList) useSwapping = false;
-	if (!onlyUpdateVisibleList)
+	// Build the hash visibility and the allocation requests. Each depth pixel is processed
+	// independently, and the buckets are locked while being inspected.
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, 16)
+#endif
+	for (int y = 0; y < depthImgSize.y; y++)
 	{
-		//allocate
-		for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
+		for (int x = 0; x < depthImgSize.x; x++)
 		{
-			int vbaIdx, exlIdx;
-			unsigned char hashChangeType = entriesAllocType[targetIdx];
+			buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
+				invProjParams_d, mu, depthImgSize, oneOverVoxelSize, voxelIndex, scene->sceneParams->viewFrustum_min,
+				scene->sceneParams->viewFrustum_max, locks);
+		}
+	}
 
-			switch (hashChangeType)
-			{
-			case 1: //needs allocation, fits in the ordered list
-				vbaIdx = lastFreeVoxelBlockId; lastFreeVoxelBlockId--;
+	// While the table grows, requests for blocks which are still in the previous table are served
+	// by moving the blocks over, so they become visible right away and are not allocated twice.
+	ITMHashEntry *oldHashTable = scene->index.GetOldEntries();
+	if (oldHashTable != NULL)
+	{
+		auto findRequestInOldTable = [=](int targetIdx) {
+			Vector4s pt_block_all = blockCoords[targetIdx];
+			return findBlockInOldTable(voxelIndex, Vector3i(pt_block_all.x, pt_block_all.y, pt_block_all.z));
+		};
+
+		ORUtils::compactStream(noTotalEntries,
+			[=](int targetIdx) { return entriesAllocType[targetIdx] == 1 && findRequestInOldTable(targetIdx) >= 0; },
+			[=](int requestIdx, int targetIdx) {
+				int oldIdx = findRequestInOldTable(targetIdx);
+
+				hashTable[targetIdx] = oldHashTable[oldIdx];
+				hashTable[targetIdx].offset = 0;
+				oldHashTable[oldIdx].ptr = -2;		// keeps its offset, so the chain stays intact
+				entriesAllocType[targetIdx] = 0;
+			});
+
+		int noExcessMoves = ORUtils::compactStream(noTotalEntries,
+			[=](int targetIdx) { return entriesAllocType[targetIdx] == 2 && findRequestInOldTable(targetIdx) >= 0; },
+			[=](int requestIdx, int targetIdx) {
+				int exlIdx = lastFreeExcessListId - requestIdx;
+				entriesAllocType[targetIdx] = 0;
+
+				// Otherwise, the block stays in the old table until it gets migrated.
+				if (exlIdx >= 0)
+				{
+					int oldIdx = findRequestInOldTable(targetIdx);
+					int exlOffset = excessAllocationList[exlIdx];
+
+					hashTable[bucketNum + exlOffset] = oldHashTable[oldIdx];
+					hashTable[bucketNum + exlOffset].offset = 0;
+					oldHashTable[oldIdx].ptr = -2;
+
+					hashTable[targetIdx].offset = exlOffset + 1;
+					entriesVisibleType[bucketNum + exlOffset] = 1;
+				}
+			});
+		lastFreeExcessListId -= std::min(noExcessMoves, lastFreeExcessListId + 1);
+	}
+
+	if (onlyUpdateVisibleList) useSwapping = false;
+	if (!onlyUpdateVisibleList)
+	{
+		// Allocate the requested blocks. The requests are compacted in hash table order, so the k-th
+		// request simply takes the k-th free slot, and the result does not depend on the threads.
+		// With the Morton-ordered allocation, the slot of every request is ranked up front instead.
+		// Requests which do not fit into the free lists are dropped, as they were in the original
+		// InfiniTAM, so that no slots are handed out which do not exist. The ordered requests get
+		// the free blocks first, and an excess request only takes a block if it got an excess entry.
+		int noFreeExcessEntries = std::max(lastFreeExcessListId + 1, 0);
+		int noFreeVoxelBlocks = std::max(lastFreeVoxelBlockId + 1, 0);
+		ORUtils::compactStream(noTotalEntries,
+			[=](int targetIdx) { return entriesAllocType[targetIdx] == 2; },
+			[=](int requestIdx, int targetIdx) { if (requestIdx >= noFreeExcessEntries) entriesAllocType[targetIdx] = 0; });
+		int noOrderedCandidates = ORUtils::compactStream(noTotalEntries,
+			[=](int targetIdx) { return entriesAllocType[targetIdx] == 1; },
+			[=](int requestIdx, int targetIdx) {
+				if (requestIdx < noFreeVoxelBlocks) return;
+				entriesAllocType[targetIdx] = 0;
+				entriesVisibleType[targetIdx] = 0;
+			});
+		int noFreeExcessVoxelBlocks = std::max(noFreeVoxelBlocks - noOrderedCandidates, 0);
+		ORUtils::compactStream(noTotalEntries,
+			[=](int targetIdx) { return entriesAllocType[targetIdx] == 2; },
+			[=](int requestIdx, int targetIdx) { if (requestIdx >= noFreeExcessVoxelBlocks) entriesAllocType[targetIdx] = 0; });
+
+		int *allocationRanks = this->allocationRanks->GetData(MEMORYDEVICE_CPU);
+		bool useAllocationRanks = useMortonOrderedAllocation;
+		int firstFreeVoxelBlockId = lastFreeVoxelBlockId;
+		if (useAllocationRanks) rankAllocationRequests_CPU(entriesAllocType, blockCoords, noTotalEntries,
+			voxelAllocationList, lastFreeVoxelBlockId, allocationRanks);
+
+		int noOrderedRequests = ORUtils::compactStream(noTotalEntries,
+			[=](int targetIdx) { return entriesAllocType[targetIdx] == 1; },
+			[=](int requestIdx, int targetIdx) {
+				//needs allocation, fits in the ordered list
+				int vbaIdx = useAllocationRanks ? firstFreeVoxelBlockId - allocationRanks[targetIdx] : lastFreeVoxelBlockId - requestIdx;
 
 				if (vbaIdx >= 0) //there is room in the voxel block array
 				{
@@ -201,14 +806,20 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 					hashEntry.pos.x = pt_block_all.x; hashEntry.pos.y = pt_block_all.y; hashEntry.pos.z = pt_block_all.z;
 					hashEntry.ptr = voxelAllocationList[vbaIdx];
 					hashEntry.offset = 0;
+					hashEntry.allocatedTime = currentFrame;
 
 					hashTable[targetIdx] = hashEntry;
+					updateBlockOccupancy_CPU(voxelIndex, hashEntry.pos.toInt(), 1);
 				}
+			});
+		lastFreeVoxelBlockId -= noOrderedRequests;
 
-				break;
-			case 2: //needs allocation in the excess list
-				vbaIdx = lastFreeVoxelBlockId; lastFreeVoxelBlockId--;
-				exlIdx = lastFreeExcessListId; lastFreeExcessListId--;
+		int noExcessRequests = ORUtils::compactStream(noTotalEntries,
+			[=](int targetIdx) { return entriesAllocType[targetIdx] == 2; },
+			[=](int requestIdx, int targetIdx) {
+				//needs allocation in the excess list
+				int vbaIdx = useAllocationRanks ? firstFreeVoxelBlockId - allocationRanks[targetIdx] : lastFreeVoxelBlockId - requestIdx;
+				int exlIdx = lastFreeExcessListId - requestIdx;
 
 				if (vbaIdx >= 0 && exlIdx >= 0) //there is room in the voxel block array and excess list
 				{
@@ -218,84 +829,185 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 					hashEntry.pos.x = pt_block_all.x; hashEntry.pos.y = pt_block_all.y; hashEntry.pos.z = pt_block_all.z;
 					hashEntry.ptr = voxelAllocationList[vbaIdx];
 					hashEntry.offset = 0;
+					hashEntry.allocatedTime = currentFrame;
 
 					int exlOffset = excessAllocationList[exlIdx];
 
 					hashTable[targetIdx].offset = exlOffset + 1; //connect to child
 
-					hashTable[SDF_BUCKET_NUM + exlOffset] = hashEntry; //add child to the excess list
+					hashTable[bucketNum + exlOffset] = hashEntry; //add child to the excess list
+					updateBlockOccupancy_CPU(voxelIndex, hashEntry.pos.toInt(), 1);
 
-					entriesVisibleType[SDF_BUCKET_NUM + exlOffset] = 1; //make child visible and in memory
+					entriesVisibleType[bucketNum + exlOffset] = 1; //make child visible and in memory
 				}
-
-				break;
-			}
-		}
+			});
+		lastFreeVoxelBlockId -= noExcessRequests;
+		lastFreeExcessListId -= noExcessRequests;
 	}
 
-	//build visible list
-	for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
-	{
-		unsigned char hashVisibleType = entriesVisibleType[targetIdx];
-		const ITMHashEntry &hashEntry = hashTable[targetIdx];
-		
-		if (hashVisibleType == 3)
-		{
-			bool isVisibleEnlarged, isVisible;
+	// Build the visible list, compacting the positions of all visible blocks into the render state.
+
+	int noVisibleBlocks = ORUtils::compactStream(noTotalEntries,
+		[=](int targetIdx) {
+			unsigned char hashVisibleType = entriesVisibleType[targetIdx];
+			const ITMHashEntry &hashEntry = hashTable[targetIdx];
+
+			if (hashVisibleType == 3)
+			{
+				bool isVisibleEnlarged, isVisible;
+
+				if (useSwapping)
+				{
+					checkBlockVisibility<true>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
+					if (!isVisibleEnlarged) hashVisibleType = 0;
+				} else {
+					checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
+					if (!isVisible) { hashVisibleType = 0; }
+				}
+				entriesVisibleType[targetIdx] = hashVisibleType;
+			}
 
 			if (useSwapping)
 			{
-				checkBlockVisibility<true>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
-				if (!isVisibleEnlarged) hashVisibleType = 0;
-			} else {
-				checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
-				if (!isVisible) { hashVisibleType = 0; }
+				if (hashVisibleType > 0 && swapStates[targetIdx].state != 2) swapStates[targetIdx].state = 1;
 			}
-			entriesVisibleType[targetIdx] = hashVisibleType;
-		}
 
-		if (useSwapping)
-		{
-			if (hashVisibleType > 0 && swapStates[targetIdx].state != 2) swapStates[targetIdx].state = 1;
-		}
+			return hashVisibleType > 0;
+		},
+		[=](int visibleIdx, int targetIdx) { visibleBlockPositions[visibleIdx] = hashTable[targetIdx].pos.toInt(); },
+		scene->index.getNumAllocatedVoxelBlocks());
 
-		if (hashVisibleType > 0)
-		{	
-			visibleEntryIDs[noVisibleEntries] = targetIdx;
-			noVisibleEntries++;
-		}
+	//reallocate deleted ones from previous swap operation
+	if (useSwapping)
+	{
+		int noReallocated = ORUtils::compactStream(noTotalEntries,
+			[=](int targetIdx) { return entriesVisibleType[targetIdx] > 0 && hashTable[targetIdx].ptr == -1; },
+			[=](int requestIdx, int targetIdx) {
+				int vbaIdx = lastFreeVoxelBlockId - requestIdx;
+				if (vbaIdx >= 0) hashTable[targetIdx].ptr = voxelAllocationList[vbaIdx];
+			});
+		lastFreeVoxelBlockId -= std::min(noReallocated, lastFreeVoxelBlockId + 1);
+	}
 
-#if 0
-		// "active list", currently disabled
-		if (hashVisibleType == 1)
-		{
-			activeEntryIDs[noActiveEntries] = targetIdx;
-			noActiveEntries++;
-		}
+	renderState_vh->noVisibleBlocks = noVisibleBlocks;
+
+	scene->localVBA.lastFreeBlockId = lastFreeVoxelBlockId;
+	scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
+
+	// Keep track of the visible blocks, which will be used later by the voxel decay mechanism.
+	ORUtils::MemoryBlock<Vector3i> *visibleBlocksCopy = nullptr;
+	if (noVisibleBlocks > 0) {
+		visibleBlocksCopy = new ORUtils::MemoryBlock<Vector3i>(noVisibleBlocks, MEMORYDEVICE_CPU);
+		memcpy(visibleBlocksCopy->GetData(MEMORYDEVICE_CPU), visibleBlockPositions, noVisibleBlocks * sizeof(Vector3i));
+	}
+	VisibleBlockInfo visibleBlockInfo = {
+		static_cast<size_t>(noVisibleBlocks),
+		frameIdx,
+		visibleBlocksCopy,
+	};
+	frameVisibleBlocks.push(visibleBlockInfo);
+	frameIdx++;
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::FullDecay(
+		ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+		const ITMRenderState *renderState,
+		int minAge,
+		int maxWeight
+) {
+	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	int *excessAllocationList = scene->index.GetExcessAllocationList();
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	const ITMVoxelBlockHash::IndexData *voxelIndex = scene->index.getIndexData();
+	uchar *entriesVisibleType = ((ITMRenderState_VH*)renderState)->GetEntriesVisibleType();
+	int *locks = this->locks->GetData(MEMORYDEVICE_CPU);
+
+	long sdfLocalBlockNum = scene->index.getNumAllocatedVoxelBlocks();
+	int noTotalEntries = scene->index.noTotalEntries;
+	int currentFrame = static_cast<int>(frameIdx);
+
+	if (allocatedBlockPositions == nullptr || allocatedBlockPositions->dataSize != static_cast<size_t>(sdfLocalBlockNum)) {
+		delete allocatedBlockPositions;
+		allocatedBlockPositions = new ORUtils::MemoryBlock<Vector4s>(sdfLocalBlockNum, MEMORYDEVICE_CPU);
+	}
+	allocatedBlockPositions->Clear();
+	Vector4s *blockPositions = allocatedBlockPositions->GetData(MEMORYDEVICE_CPU);
+
+	// First, we check every bucket and see if it's allocated, populating each index in
+	// `blockPositions` with the block's position, whereby every element in this array corresponds
+	// to a VBA element. We need the snapshot because the deletions modify the table.
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
 #endif
+	for (int entryId = 0; entryId < noTotalEntries; entryId++)
+	{
+		const ITMHashEntry &currentHashEntry = hashTable[entryId];
+		if (currentHashEntry.ptr >= 0) {
+			blockPositions[currentHashEntry.ptr] = Vector4s(
+					currentHashEntry.pos.x, currentHashEntry.pos.y, currentHashEntry.pos.z, 1);
+		}
 	}
 
-	//reallocate deleted ones from previous swap operation
-	if (useSwapping)
+	int lastFreeBlockId = scene->localVBA.lastFreeBlockId;
+	int lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
+	memset(locks, 0, sizeof(int) * scene->index.getBucketNum());
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int voxelBlockIdx = 0; voxelBlockIdx < sdfLocalBlockNum; voxelBlockIdx++)
 	{
-		for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
-		{
-			int vbaIdx;
-			ITMHashEntry hashEntry = hashTable[targetIdx];
+		const Vector4s &blockGridPos_4s = blockPositions[voxelBlockIdx];
 
-			if (entriesVisibleType[targetIdx] > 0 && hashEntry.ptr == -1) 
-			{
-				vbaIdx = lastFreeVoxelBlockId; lastFreeVoxelBlockId--;
-				if (vbaIdx >= 0) hashTable[targetIdx].ptr = voxelAllocationList[vbaIdx];
-			}
-		}
+		// A zero means no hash table entry points to this block.
+		if (blockGridPos_4s.w == 0) continue;
+
+		Vector3i blockPos(blockGridPos_4s.x, blockGridPos_4s.y, blockGridPos_4s.z);
+		decayBlock_CPU<TVoxel>(blockPos, scene->localVBA, voxelIndex, minAge, maxWeight, voxelAllocationList,
+							   &lastFreeBlockId, excessAllocationList, &lastFreeExcessListId, locks,
+							   currentFrame, entriesVisibleType);
 	}
 
-	renderState_vh->noVisibleEntries = noVisibleEntries;
+	scene->localVBA.lastFreeBlockId = lastFreeBlockId;
+	scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
+}
 
-	scene->localVBA.lastFreeBlockId = lastFreeVoxelBlockId;
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::PartialDecay(
+		ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+		const ITMRenderState *renderState,
+		const VisibleBlockInfo &visibleBlockInfo,
+		int minAge,
+		int maxWeight
+) {
+	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	int *excessAllocationList = scene->index.GetExcessAllocationList();
+	const ITMVoxelBlockHash::IndexData *voxelIndex = scene->index.getIndexData();
+	uchar *entriesVisibleType = ((ITMRenderState_VH*)renderState)->GetEntriesVisibleType();
+	int *locks = this->locks->GetData(MEMORYDEVICE_CPU);
+	const Vector3i *visibleBlockPositions = visibleBlockInfo.blockCoords->GetData(MEMORYDEVICE_CPU);
+
+	int noBlocks = static_cast<int>(visibleBlockInfo.count);
+	int currentFrame = static_cast<int>(frameIdx);
+	int lastFreeBlockId = scene->localVBA.lastFreeBlockId;
+	int lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
+	memset(locks, 0, sizeof(int) * scene->index.getBucketNum());
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++)
+	{
+		decayBlock_CPU<TVoxel>(visibleBlockPositions[blockIdx], scene->localVBA, voxelIndex, minAge, maxWeight,
+							   voxelAllocationList, &lastFreeBlockId, excessAllocationList,
+							   &lastFreeExcessListId, locks, currentFrame, entriesVisibleType);
+	}
+
+	scene->localVBA.lastFreeBlockId = lastFreeBlockId;
 	scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
-   */
+
+	delete visibleBlockInfo.blockCoords;
 }
 
 template<class TVoxel>
@@ -306,17 +1018,238 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::Decay(
 		int minAge,
 		bool forceAllVoxels
 ){
-	throw std::runtime_error("Voxel decay is not yet supported on the CPU.");
+	// The decay only finds the blocks in the current table, so the blocks of a growing table are
+	// all migrated first.
+	if (scene->index.IsGrowing()) migrateHashBuckets_CPU(scene->index, scene->index.getOldBucketNum());
+	FitBuffersToTable(scene->index);
+
+	int oldLastFreeBlockId = scene->localVBA.lastFreeBlockId;
+
+	if (forceAllVoxels) {
+		FullDecay(scene, renderState, minAge, maxWeight);
+	}
+	else if (static_cast<long>(frameVisibleBlocks.size()) > minAge) {
+		// No full decay, just operate on the voxel blocks seen 'minAge' frames ago.
+		VisibleBlockInfo visible = frameVisibleBlocks.front();
+		frameVisibleBlocks.pop();
+
+		if (visible.count > 0) {
+			PartialDecay(scene, renderState, visible, minAge, maxWeight);
+		}
+	}
+
+	int freedBlockCount = scene->localVBA.lastFreeBlockId - oldLastFreeBlockId;
+	totalDecayedBlockCount += freedBlockCount;
 }
 
 template<class TVoxel>
 size_t ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::GetDecayedBlockCount()
 {
-	throw std::runtime_error("Voxel decay is not yet supported on the CPU.");
+	return static_cast<size_t>(totalDecayedBlockCount);
+}
+
+template<class TVoxel>
+ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::ITMSceneReconstructionEngine_CPU(int sdfSlotNum, int sdfExcessListSize)
+	: sdfSlotNum(sdfSlotNum)
+{
+	if (sdfExcessListSize != 0) {
+		throw std::runtime_error("An open-addressing hash table has no excess list; its size must be 0.");
+	}
+
+	entriesAllocType = new ORUtils::MemoryBlock<unsigned char>(sdfSlotNum, MEMORYDEVICE_CPU);
+	blockCoords = new ORUtils::MemoryBlock<Vector4s>(sdfSlotNum, MEMORYDEVICE_CPU);
+	allocationRanks = new ORUtils::MemoryBlock<int>(sdfSlotNum, MEMORYDEVICE_CPU);
+	locks = new ORUtils::MemoryBlock<int>(sdfSlotNum, MEMORYDEVICE_CPU);
+}
+
+template<class TVoxel>
+ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::~ITMSceneReconstructionEngine_CPU(void)
+{
+	delete entriesAllocType;
+	delete blockCoords;
+	delete allocationRanks;
+	delete locks;
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::ResetScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene)
+{
+	int numBlocks = scene->index.getNumAllocatedVoxelBlocks();
+	int blockSize = scene->index.getVoxelBlockSize();
+
+	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
+	for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
+	scene->localVBA.VoxelsChanged(0, numBlocks * blockSize);
+	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
+	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
+	scene->localVBA.lastFreeBlockId = numBlocks - 1;
+
+	ITMHashEntry tmpEntry;
+	memset(&tmpEntry, 0, sizeof(ITMHashEntry));
+	tmpEntry.ptr = -2;
+	ITMHashEntry *hashEntry_ptr = scene->index.GetEntries();
+	for (int i = 0; i < scene->index.noTotalEntries; ++i) hashEntry_ptr[i] = tmpEntry;
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene, const ITMView *view,
+	const ITMTrackingState *trackingState, const ITMRenderState *renderState)
+{
+	IntegrateIntoScene_common(scene, view, trackingState, renderState, useVectorisedIntegration, this->GetFusionWeightParams());
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::AllocateSceneFromDepth(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene, const ITMView *view,
+	const ITMTrackingState *trackingState, const ITMRenderState *renderState, bool onlyUpdateVisibleList)
+{
+	Vector2i depthImgSize = view->depth->noDims;
+	float voxelSize = scene->sceneParams->voxelSize;
+
+	Matrix4f M_d, invM_d;
+	Vector4f projParams_d, invProjParams_d;
+
+	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+
+	if (scene->useSwapping) {
+		throw std::runtime_error("Swapping is not supported with open-addressing hash tables.");
+	}
+	if (scene->index.getSlotNum() != sdfSlotNum) {
+		throw std::runtime_error("The hash table of the scene does not have the size the "
+								 "reconstruction engine was created for.");
+	}
+
+	M_d = trackingState->pose_d->GetM(); M_d.inv(invM_d);
+
+	projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
+	invProjParams_d = projParams_d;
+	invProjParams_d.x = 1.0f / invProjParams_d.x;
+	invProjParams_d.y = 1.0f / invProjParams_d.y;
+
+	float mu = scene->sceneParams->mu;
+
+	float *depth = view->depth->GetData(MEMORYDEVICE_CPU);
+	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	const ITMVoxelBlockOpenHash::IndexData *voxelIndex = scene->index.getIndexData();
+	Vector3i *visibleBlockPositions = renderState_vh->GetVisibleBlockPositions();
+	uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
+	uchar *entriesAllocType = this->entriesAllocType->GetData(MEMORYDEVICE_CPU);
+	Vector4s *blockCoords = this->blockCoords->GetData(MEMORYDEVICE_CPU);
+	int *locks = this->locks->GetData(MEMORYDEVICE_CPU);
+	int noTotalEntries = scene->index.noTotalEntries;
+	int noPreviouslyVisibleBlocks = renderState_vh->noVisibleBlocks;
+	int currentFrame = static_cast<int>(frameIdx);
+
+	float oneOverVoxelSize = 1.0f / (voxelSize * SDF_BLOCK_SIZE);
+
+	int lastFreeVoxelBlockId = scene->localVBA.lastFreeBlockId;
+
+	memset(entriesAllocType, 0, noTotalEntries);
+	memset(locks, 0, sizeof(int) * noTotalEntries);
+
+	// Flag the blocks which were visible in the previous frame (type 3), so they can be re-checked
+	// against the current pose when building the visible list.
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int visibleIdx = 0; visibleIdx < noPreviouslyVisibleBlocks; visibleIdx++)
+	{
+		bool isFound = false;
+		int hashIdx = findBlock(voxelIndex, visibleBlockPositions[visibleIdx], isFound);
+		if (isFound) entriesVisibleType[hashIdx] = 3;
+	}
+
+	// Build the hash visibility and the allocation requests. A missing block requests the first
+	// empty slot on its probe sequence; the slot is locked while the request is being written.
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, 16)
+#endif
+	for (int y = 0; y < depthImgSize.y; y++)
+	{
+		for (int x = 0; x < depthImgSize.x; x++)
+		{
+			buildOpenHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
+				invProjParams_d, mu, depthImgSize, oneOverVoxelSize, voxelIndex, scene->sceneParams->viewFrustum_min,
+				scene->sceneParams->viewFrustum_max, locks);
+		}
+	}
+
+	if (!onlyUpdateVisibleList)
+	{
+		// Unlike with the chained hash, a request already points at the slot where the block goes,
+		// so there is no equivalent of the excess list pass. Requests past the free blocks are
+		// dropped, and their slots stay empty.
+		int noFreeVoxelBlocks = std::max(lastFreeVoxelBlockId + 1, 0);
+		ORUtils::compactStream(noTotalEntries,
+			[=](int targetIdx) { return entriesAllocType[targetIdx] == 1; },
+			[=](int requestIdx, int targetIdx) { if (requestIdx >= noFreeVoxelBlocks) entriesAllocType[targetIdx] = 0; });
+
+		int *allocationRanks = this->allocationRanks->GetData(MEMORYDEVICE_CPU);
+		bool useAllocationRanks = useMortonOrderedAllocation;
+		if (useAllocationRanks) rankAllocationRequests_CPU(entriesAllocType, blockCoords, noTotalEntries,
+			voxelAllocationList, lastFreeVoxelBlockId, allocationRanks);
+
+		int noRequests = ORUtils::compactStream(noTotalEntries,
+			[=](int targetIdx) { return entriesAllocType[targetIdx] == 1; },
+			[=](int requestIdx, int targetIdx) {
+				int vbaIdx = lastFreeVoxelBlockId - (useAllocationRanks ? allocationRanks[targetIdx] : requestIdx);
+
+				if (vbaIdx >= 0) //there is room in the voxel block array
+				{
+					Vector4s pt_block_all = blockCoords[targetIdx];
+
+					ITMHashEntry hashEntry;
+					hashEntry.pos.x = pt_block_all.x; hashEntry.pos.y = pt_block_all.y; hashEntry.pos.z = pt_block_all.z;
+					hashEntry.ptr = voxelAllocationList[vbaIdx];
+					hashEntry.offset = 0;
+					hashEntry.allocatedTime = currentFrame;
+
+					hashTable[targetIdx] = hashEntry;
+				}
+			});
+		lastFreeVoxelBlockId -= noRequests;
+	}
+
+	// Build the visible list. Slots whose allocation request could not be served stay empty, and
+	// are skipped.
+	int noVisibleBlocks = ORUtils::compactStream(noTotalEntries,
+		[=](int targetIdx) {
+			unsigned char hashVisibleType = entriesVisibleType[targetIdx];
+			const ITMHashEntry &hashEntry = hashTable[targetIdx];
+
+			if (hashVisibleType == 3)
+			{
+				bool isVisibleEnlarged, isVisible;
+				checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
+				if (!isVisible) { hashVisibleType = 0; }
+				entriesVisibleType[targetIdx] = hashVisibleType;
+			}
+
+			return hashVisibleType > 0 && hashEntry.ptr >= 0;
+		},
+		[=](int visibleIdx, int targetIdx) { visibleBlockPositions[visibleIdx] = hashTable[targetIdx].pos.toInt(); },
+		scene->index.getNumAllocatedVoxelBlocks());
+
+	renderState_vh->noVisibleBlocks = noVisibleBlocks;
+	scene->localVBA.lastFreeBlockId = lastFreeVoxelBlockId;
+	frameIdx++;
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::Decay(
+		ITMScene<TVoxel, ITMVoxelBlockOpenHash>*, const ITMRenderState *, int, int, bool
+) {
+	throw std::runtime_error("Voxel decay is not supported with open-addressing hash tables.");
+}
+
+template<class TVoxel>
+size_t ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::GetDecayedBlockCount()
+{
+	return 0;
 }
 
 template<class TVoxel>
-ITMSceneReconstructionEngine_CPU<TVoxel,ITMPlainVoxelArray>::ITMSceneReconstructionEngine_CPU(void) 
+ITMSceneReconstructionEngine_CPU<TVoxel,ITMPlainVoxelArray>::ITMSceneReconstructionEngine_CPU(int sdfBucketNum, int sdfExcessListSize)
 {}
 
 template<class TVoxel>
@@ -331,6 +1264,7 @@ void ITMSceneReconstructionEngine_CPU<TVoxel,ITMPlainVoxelArray>::ResetScene(ITM
 
 	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
 	for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
+	scene->localVBA.VoxelsChanged(0, numBlocks * blockSize);
 	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
 	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
 	scene->localVBA.lastFreeBlockId = numBlocks - 1;
@@ -368,6 +1302,7 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 
 	bool stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
 	//bool approximateIntegration = !trackingState->requiresFullRendering;
+	WeightParams fusionWeightParams = this->GetFusionWeightParams();
 
 #ifdef WITH_OPENMP
 	#pragma omp parallel for
@@ -389,8 +1324,10 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 		pt_model.w = 1.0f;
 
 		ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation,TVoxel>::compute(voxelArray[locId], pt_model, M_d, projParams_d, M_rgb, projParams_rgb, mu, maxW, 
-			depth, depthImgSize, rgb, rgbImgSize);
+			depth, depthImgSize, rgb, rgbImgSize, fusionWeightParams);
 	}
+
+	scene->localVBA.VoxelsChanged(0, scene->index.getVolumeSize().x * scene->index.getVolumeSize().y * scene->index.getVolumeSize().z);
 }
 
 template<class TVoxel>
@@ -408,3 +1345,6 @@ size_t ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::GetDecayedB
 }
 
 template class ITMLib::Engine::ITMSceneReconstructionEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+#if ITM_VOXEL_INDEX != ITM_VOXEL_INDEX_OPEN_HASH
+template class ITMLib::Engine::ITMSceneReconstructionEngine_CPU<ITMVoxel, ITMVoxelBlockOpenHash>;
+#endif
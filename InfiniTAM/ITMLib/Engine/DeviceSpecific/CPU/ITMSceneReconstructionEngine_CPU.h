@@ -4,6 +4,8 @@
 
 #include "../../ITMSceneReconstructionEngine.h"
 
+#include <queue>
+
 namespace ITMLib
 {
 	namespace Engine
@@ -16,8 +18,53 @@ namespace ITMLib
 		class ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash> : public ITMSceneReconstructionEngine < TVoxel, ITMVoxelBlockHash >
 		{
 		protected:
+			// Sizes of the hash table the per-entry buffers below were allocated for. Follow the
+			// table of the scene when it grows.
+			int sdfBucketNum;
+			int sdfExcessListSize;
+
 			ORUtils::MemoryBlock<unsigned char> *entriesAllocType;
 			ORUtils::MemoryBlock<Vector4s> *blockCoords;
+			// Which free VBA slot each allocation request takes; see SetMortonOrderedAllocation.
+			ORUtils::MemoryBlock<int> *allocationRanks;
+			// Used to avoid data races when several threads touch the same bucket.
+			ORUtils::MemoryBlock<int> *locks;
+
+			// Keeps track of recent lists of visible block IDs. Used by the voxel decay.
+			std::queue<VisibleBlockInfo> frameVisibleBlocks;
+			// Used by the full-volume decay code. Allocated on first use, since the size of the
+			// VBA is only known once we see a scene.
+			ORUtils::MemoryBlock<Vector4s> *allocatedBlockPositions = nullptr;
+
+			long totalDecayedBlockCount = 0L;
+			size_t frameIdx = 0;
+
+			// Whether to integrate whole voxel blocks in SIMD-friendly passes, or one voxel at a time.
+			bool useVectorisedIntegration = true;
+			// Whether the blocks allocated in a frame take their VBA slots in Morton order.
+			bool useMortonOrderedAllocation = true;
+
+			/// \brief Runs a voxel decay process on the blocks specified in `visibleBlockInfo`.
+			void PartialDecay(
+				ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+				const ITMRenderState *renderState,
+				const VisibleBlockInfo &visibleBlockInfo,
+				int minAge,
+				int maxWeight);
+
+			/// \brief Reallocates the per-entry buffers if the hash table has a different size.
+			void FitBuffersToTable(const ITMVoxelBlockHash &index);
+
+			/// \brief Starts growing the hash table of the scene if it is getting full, and
+			///        migrates the next batch of buckets if it is already growing.
+			void UpdateHashTableGrowth(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
+
+			/// \brief Runs a voxel decay process on the entire volume.
+			void FullDecay(
+				ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+				const ITMRenderState *renderState,
+				int minAge,
+				int maxWeight);
 
 		public:
 			void ResetScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
@@ -34,7 +81,72 @@ namespace ITMLib
 
 			size_t GetDecayedBlockCount() override;
 
-			ITMSceneReconstructionEngine_CPU(void);
+			/// \brief Switches between the vectorised block integration (default) and the scalar
+			///        per-voxel fallback. Both produce the same volume.
+			void SetVectorisedIntegration(bool useVectorisedIntegration) {
+				this->useVectorisedIntegration = useVectorisedIntegration;
+			}
+
+			/// \brief Switches between handing out the free VBA slots to the blocks allocated in a
+			///        frame in the Morton order of their positions (default), so that neighbouring
+			///        blocks are close in memory, and handing them out in hash table order.
+			void SetMortonOrderedAllocation(bool useMortonOrderedAllocation) {
+				this->useMortonOrderedAllocation = useMortonOrderedAllocation;
+			}
+
+			ITMSceneReconstructionEngine_CPU(int sdfBucketNum = DEFAULT_SDF_BUCKET_NUM,
+											 int sdfExcessListSize = DEFAULT_SDF_EXCESS_LIST_SIZE);
+			~ITMSceneReconstructionEngine_CPU(void);
+		};
+
+		template<class TVoxel>
+		class ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash> : public ITMSceneReconstructionEngine < TVoxel, ITMVoxelBlockOpenHash >
+		{
+		protected:
+			// Number of slots of the hash tables this engine can work with; see ITMLibSettings.
+			int sdfSlotNum;
+
+			ORUtils::MemoryBlock<unsigned char> *entriesAllocType;
+			ORUtils::MemoryBlock<Vector4s> *blockCoords;
+			ORUtils::MemoryBlock<int> *allocationRanks;
+			// Used to avoid data races when several threads request the same empty slot.
+			ORUtils::MemoryBlock<int> *locks;
+
+			size_t frameIdx = 0;
+
+			// Whether to integrate whole voxel blocks in SIMD-friendly passes, or one voxel at a time.
+			bool useVectorisedIntegration = true;
+			bool useMortonOrderedAllocation = true;
+
+		public:
+			void ResetScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene);
+
+			void AllocateSceneFromDepth(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+				const ITMRenderState *renderState, bool onlyUpdateVisibleList = false);
+
+			void IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+				const ITMRenderState *renderState);
+
+			void Decay(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene,
+                       const ITMRenderState *renderState,
+					   int maxWeight, int minAge, bool forceAllVoxels) override;
+
+			size_t GetDecayedBlockCount() override;
+
+			/// \brief See ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>.
+			void SetVectorisedIntegration(bool useVectorisedIntegration) {
+				this->useVectorisedIntegration = useVectorisedIntegration;
+			}
+
+			/// \brief See ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>.
+			void SetMortonOrderedAllocation(bool useMortonOrderedAllocation) {
+				this->useMortonOrderedAllocation = useMortonOrderedAllocation;
+			}
+
+			/// The second argument keeps the signature in line with the chained hash. There is no
+			/// excess list, so it must be 0.
+			ITMSceneReconstructionEngine_CPU(int sdfSlotNum = DEFAULT_SDF_BUCKET_NUM,
+											 int sdfExcessListSize = 0);
 			~ITMSceneReconstructionEngine_CPU(void);
 		};
 
@@ -56,7 +168,9 @@ namespace ITMLib
 
 			size_t GetDecayedBlockCount() override;
 
-			ITMSceneReconstructionEngine_CPU(void);
+			/// The hash table sizes are ignored; they keep the signature in line with the hashed
+			/// indices, so that ITMDenseMapper can build the engine for any of them.
+			ITMSceneReconstructionEngine_CPU(int sdfBucketNum = 0, int sdfExcessListSize = 0);
 			~ITMSceneReconstructionEngine_CPU(void);
 		};
 	}
@@ -3,6 +3,7 @@
 #include "ITMSwappingEngine_CPU.h"
 #include "../../DeviceAgnostic/ITMSwappingEngine.h"
 #include "../../../Objects/ITMRenderState_VH.h"
+#include "../../../../ORUtils/StreamCompaction.h"
 
 using namespace ITMLib::Engine;
 
@@ -31,16 +32,10 @@ int ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 
 	int noTotalEntries = globalCache->noTotalEntries;
 
-	int noNeededEntries = 0;
-	for (int entryId = 0; entryId < noTotalEntries; entryId++)
-	{
-		if (noNeededEntries >= SDF_TRANSFER_BLOCK_NUM) break;
-		if (swapStates[entryId].state == 1)
-		{
-			neededEntryIDs_local[noNeededEntries] = entryId;
-			noNeededEntries++;
-		}
-	}
+	// The first SDF_TRANSFER_BLOCK_NUM entries which need to be swapped in, in hash table order.
+	int noNeededEntries = ORUtils::compactIndices(noTotalEntries,
+		[=](int entryId) { return swapStates[entryId].state == 1; },
+		neededEntryIDs_local, SDF_TRANSFER_BLOCK_NUM);
 
 	// would copy neededEntryIDs_local into neededEntryIDs_global here
 
@@ -48,6 +43,9 @@ int ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 	{
 		memset(syncedVoxelBlocks_global, 0, noNeededEntries * SDF_BLOCK_SIZE3 * sizeof(TVoxel));
 		memset(hasSyncedData_global, 0, noNeededEntries * sizeof(bool));
+#ifdef WITH_OPENMP
+		#pragma omp parallel for
+#endif
 		for (int i = 0; i < noNeededEntries; i++)
 		{
 			int entryId = neededEntryIDs_global[i];
@@ -97,6 +95,7 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateGlobalIntoLocal(
 			{
 				CombineVoxelInformation<TVoxel::hasColorInformation, TVoxel>::compute(srcVB[vIdx], dstVB[vIdx], maxW);
 			}
+			scene->localVBA.VoxelsChanged(hashTable[entryDestId].ptr * SDF_BLOCK_SIZE3, SDF_BLOCK_SIZE3);
 		}
 
 		swapStates[entryDestId].state = 2;
@@ -126,42 +125,43 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 
 	int noTotalEntries = globalCache->noTotalEntries;
 	
-	int noNeededEntries = 0;
 	int noAllocatedVoxelEntries = scene->localVBA.lastFreeBlockId;
-
-	for (int entryDestId = 0; entryDestId < noTotalEntries; entryDestId++)
+	int sdfLocalBlockNum = scene->index.getNumAllocatedVoxelBlocks();
+
+	// The first SDF_TRANSFER_BLOCK_NUM entries which can be swapped out, in hash table order.
+	int noNeededEntries = ORUtils::compactIndices(noTotalEntries,
+		[=](int entryDestId) {
+			return swapStates[entryDestId].state == 2 && hashTable[entryDestId].ptr >= 0 && entriesVisibleType[entryDestId] == 0;
+		},
+		neededEntryIDs_local, SDF_TRANSFER_BLOCK_NUM);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int i = 0; i < noNeededEntries; i++)
 	{
-		if (noNeededEntries >= SDF_TRANSFER_BLOCK_NUM) break;
-
+		int entryDestId = neededEntryIDs_local[i];
 		int localPtr = hashTable[entryDestId].ptr;
-		ITMHashSwapState &swapState = swapStates[entryDestId];
+		TVoxel *localVBALocation = localVBA + localPtr * SDF_BLOCK_SIZE3;
 
-		if (swapState.state == 2 && localPtr >= 0 && entriesVisibleType[entryDestId] == 0)
-		{
-			TVoxel *localVBALocation = localVBA + localPtr * SDF_BLOCK_SIZE3;
-
-			neededEntryIDs_local[noNeededEntries] = entryDestId;
+		hasSyncedData_local[i] = true;
+		memcpy(syncedVoxelBlocks_local + i * SDF_BLOCK_SIZE3, localVBALocation, SDF_BLOCK_SIZE3 * sizeof(TVoxel));
 
-			hasSyncedData_local[noNeededEntries] = true;
-			memcpy(syncedVoxelBlocks_local + noNeededEntries * SDF_BLOCK_SIZE3, localVBALocation, SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+		swapStates[entryDestId].state = 0;
 
-			swapStates[entryDestId].state = 0;
-
-			int vbaIdx = noAllocatedVoxelEntries;
-			if (vbaIdx < SDF_BUCKET_NUM - 1)
-			{
-				noAllocatedVoxelEntries++;
-				voxelAllocationList[vbaIdx + 1] = localPtr;
-				hashTable[entryDestId].ptr = -1;
-
-				for (int i = 0; i < SDF_BLOCK_SIZE3; i++) localVBALocation[i] = TVoxel();
-			}
+		int vbaIdx = noAllocatedVoxelEntries + i;
+		if (vbaIdx < sdfLocalBlockNum - 1)
+		{
+			voxelAllocationList[vbaIdx + 1] = localPtr;
+			hashTable[entryDestId].ptr = -1;
 
-			noNeededEntries++;
+			for (int j = 0; j < SDF_BLOCK_SIZE3; j++) localVBALocation[j] = TVoxel();
+			scene->localVBA.VoxelsChanged(localPtr * SDF_BLOCK_SIZE3, SDF_BLOCK_SIZE3);
 		}
 	}
 
-	scene->localVBA.lastFreeBlockId = noAllocatedVoxelEntries;
+	int noFreedEntries = MAX(0, MIN(noNeededEntries, sdfLocalBlockNum - 1 - noAllocatedVoxelEntries));
+	scene->localVBA.lastFreeBlockId = noAllocatedVoxelEntries + noFreedEntries;
 
 	// would copy neededEntryIDs_local, hasSyncedData_local and syncedVoxelBlocks_local into *_global here
 
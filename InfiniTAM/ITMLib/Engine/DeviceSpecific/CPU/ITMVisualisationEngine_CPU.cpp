@@ -5,9 +5,14 @@
 #include "../../DeviceAgnostic/ITMVisualisationEngine.h"
 #include "../../DeviceAgnostic/ITMSceneReconstructionEngine.h"
 #include "../../../Objects/ITMRenderState_VH.h"
+#include "../../../../ORUtils/StreamCompaction.h"
 
 #include <vector>
 
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
 using namespace ITMLib::Engine;
 
 template<class TVoxel, class TIndex>
@@ -27,10 +32,57 @@ template<class TVoxel>
 ITMRenderState_VH* ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockHash>::CreateRenderState(const Vector2i & imgSize) const
 {
 	return new ITMRenderState_VH(
-		ITMVoxelBlockHash::noTotalEntries, imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, this->settings->sdfLocalBlockNum, MEMORYDEVICE_CPU
+		this->scene->index.noTotalEntries, imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, this->settings->sdfLocalBlockNum, MEMORYDEVICE_CPU
+	);
+}
+
+template<class TVoxel>
+ITMRenderState_VH* ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::CreateRenderState(const Vector2i & imgSize) const
+{
+	return new ITMRenderState_VH(
+		this->scene->index.noTotalEntries, imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, this->settings->sdfLocalBlockNum, MEMORYDEVICE_CPU
 	);
 }
 
+/// \brief Builds the list of visible blocks of a hashed scene, for any index which stores
+///        ITMHashEntry elements.
+template<class TVoxel, class TIndex>
+static void FindVisibleBlocks_common(const ITMScene<TVoxel, TIndex> *scene, const ITMPose *pose, const ITMIntrinsics *intrinsics,
+	ITMRenderState *renderState, long sdfLocalBlockNum)
+{
+	const ITMHashEntry *hashTable = scene->index.GetEntries();
+	int noTotalEntries = scene->index.noTotalEntries;
+	float voxelSize = scene->sceneParams->voxelSize;
+	Vector2i imgSize = renderState->renderingRangeImage->noDims;
+
+	// While a hash table grows, the blocks which have not been migrated yet are in the old table.
+	const ITMHashEntry *oldHashTable = scene->index.GetOldEntries();
+	int noOldEntries = scene->index.getOldNoTotalEntries();
+	auto getEntry = [=](int entryIdx) -> const ITMHashEntry & {
+		return (entryIdx < noTotalEntries) ? hashTable[entryIdx] : oldHashTable[entryIdx - noTotalEntries];
+	};
+
+	Matrix4f M = pose->GetM();
+	Vector4f projParams = intrinsics->projectionParamsSimple.all;
+
+	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+	Vector3i *visibleBlockPositions = renderState_vh->GetVisibleBlockPositions();
+
+	//build visible list
+	renderState_vh->noVisibleBlocks = ORUtils::compactStream(noTotalEntries + noOldEntries,
+		[=](int targetIdx) {
+			const ITMHashEntry &hashEntry = getEntry(targetIdx);
+			if (hashEntry.ptr < 0) return false;
+
+			bool isVisible, isVisibleEnlarged;
+			checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, M, projParams, voxelSize, imgSize);
+			return isVisible;
+		},
+		[=](int visibleIdx, int targetIdx) { visibleBlockPositions[visibleIdx] = getEntry(targetIdx).pos.toInt(); },
+		static_cast<int>(sdfLocalBlockNum));
+}
+
+
 template<class TVoxel, class TIndex>
 void ITMVisualisationEngine_CPU<TVoxel, TIndex>::FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const
 {
@@ -40,42 +92,96 @@ template<class TVoxel>
 void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
 	ITMRenderState *renderState) const
 {
-	/*
-	const ITMHashEntry *hashTable = this->scene->index.GetEntries();
-	int noTotalEntries = this->scene->index.noTotalEntries;
-	float voxelSize = this->scene->sceneParams->voxelSize;
+	FindVisibleBlocks_common(this->scene, pose, intrinsics, renderState, this->settings->sdfLocalBlockNum);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	ITMRenderState *renderState) const
+{
+	FindVisibleBlocks_common(this->scene, pose, intrinsics, renderState, this->settings->sdfLocalBlockNum);
+}
+
+/// \brief Computes the expected depth ranges of a hashed scene, by projecting every visible block
+///        into the subsampled range image. This is what projectAndSplitBlocks_device and
+///        fillBlocks_device do on the GPU. Instead of splitting the projections into 16x16 rendering
+///        blocks which are then filled with atomics, every thread takes the min/max of its blocks
+///        in a range image of its own, and the images of all threads are merged at the end.
+template<class TVoxel, class TIndex>
+static void CreateExpectedDepths_common(const ITMScene<TVoxel, TIndex> *scene, const ITMPose *pose, const ITMIntrinsics *intrinsics,
+	ITMRenderState *renderState)
+{
 	Vector2i imgSize = renderState->renderingRangeImage->noDims;
+	Vector2f *minmaxData = renderState->renderingRangeImage->GetData(MEMORYDEVICE_CPU);
+	float voxelSize = scene->sceneParams->voxelSize;
 
 	Matrix4f M = pose->GetM();
 	Vector4f projParams = intrinsics->projectionParamsSimple.all;
 
+	// Only the top left corner of the range image is used, with the same row stride as the image.
+	Vector2i rangeSize((imgSize.x + minmaximg_subsample - 1) / minmaximg_subsample,
+		(imgSize.y + minmaximg_subsample - 1) / minmaximg_subsample);
+	int noRangePixels = rangeSize.x * rangeSize.y;
+
 	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+	const Vector3i *visibleBlockPositions = renderState_vh->GetVisibleBlockPositions();
+	int noVisibleBlocks = renderState_vh->noVisibleBlocks;
 
-	int noVisibleEntries = 0;
-	int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
+	int maxThreads = 1;
+#ifdef WITH_OPENMP
+	maxThreads = omp_get_max_threads();
+#endif
+	std::vector<Vector2f> threadRanges(static_cast<size_t>(maxThreads) * noRangePixels, Vector2f(FAR_AWAY, VERY_CLOSE));
 
-	//build visible list
-	for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int blockNo = 0; blockNo < noVisibleBlocks; ++blockNo)
 	{
-		unsigned char hashVisibleType = 0;// = entriesVisibleType[targetIdx];
-		const ITMHashEntry &hashEntry = hashTable[targetIdx];
+		int threadId = 0;
+#ifdef WITH_OPENMP
+		threadId = omp_get_thread_num();
+#endif
+		Vector2f *ranges = &threadRanges[static_cast<size_t>(threadId) * noRangePixels];
 
-		if (hashEntry.ptr >= 0)
+		const Vector3i &blockPos = visibleBlockPositions[blockNo];
+		Vector2i upperLeft, lowerRight;
+		Vector2f zRange;
+		if (!ProjectSingleBlock(Vector3s((short)blockPos.x, (short)blockPos.y, (short)blockPos.z), M, projParams, imgSize,
+			voxelSize, upperLeft, lowerRight, zRange)) continue;
+
+		// ProjectSingleBlock only clamps to the full image size.
+		if (lowerRight.x >= rangeSize.x) lowerRight.x = rangeSize.x - 1;
+		if (lowerRight.y >= rangeSize.y) lowerRight.y = rangeSize.y - 1;
+
+		for (int y = upperLeft.y; y <= lowerRight.y; ++y) for (int x = upperLeft.x; x <= lowerRight.x; ++x)
 		{
-			bool isVisible, isVisibleEnlarged;
-			checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, M, projParams, voxelSize, imgSize);
-			hashVisibleType = isVisible;
+			Vector2f &pixel = ranges[x + y * rangeSize.x];
+			if (pixel.x > zRange.x) pixel.x = zRange.x;
+			if (pixel.y < zRange.y) pixel.y = zRange.y;
 		}
+	}
 
-		if (hashVisibleType > 0)
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int locId = 0; locId < imgSize.x * imgSize.y; ++locId)
+	{
+		int y = locId / imgSize.x, x = locId - y * imgSize.x;
+		Vector2f pixel(FAR_AWAY, VERY_CLOSE);
+
+		if (x < rangeSize.x && y < rangeSize.y)
 		{
-			visibleEntryIDs[noVisibleEntries] = targetIdx;
-			noVisibleEntries++;
+			for (int threadId = 0; threadId < maxThreads; ++threadId)
+			{
+				const Vector2f &threadPixel = threadRanges[static_cast<size_t>(threadId) * noRangePixels + x + y * rangeSize.x];
+				if (pixel.x > threadPixel.x) pixel.x = threadPixel.x;
+				if (pixel.y < threadPixel.y) pixel.y = threadPixel.y;
+			}
 		}
-	}
 
-	renderState_vh->noVisibleEntries = noVisibleEntries;
-	 */
+		minmaxData[locId] = pixel;
+	}
 }
 
 template<class TVoxel, class TIndex>
@@ -96,67 +202,69 @@ template<class TVoxel>
 void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
 	ITMRenderState *renderState) const
 {
-	/*
-	Vector2i imgSize = renderState->renderingRangeImage->noDims;
-	Vector2f *minmaxData = renderState->renderingRangeImage->GetData(MEMORYDEVICE_CPU);
-
-	for (int locId = 0; locId < imgSize.x*imgSize.y; ++locId) {
-		Vector2f & pixel = minmaxData[locId];
-		pixel.x = FAR_AWAY;
-		pixel.y = VERY_CLOSE;
-	}
-
-	float voxelSize = this->scene->sceneParams->voxelSize;
-
-	std::vector<RenderingBlock> renderingBlocks(MAX_RENDERING_BLOCKS);
-	int numRenderingBlocks = 0;
-
-	ITMRenderState_VH* renderState_vh = (ITMRenderState_VH*)renderState;
-
-	const int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
-	int noVisibleEntries = renderState_vh->noVisibleEntries;
-
-	//go through list of visible 8x8x8 blocks
-	for (int blockNo = 0; blockNo < noVisibleEntries; ++blockNo) {
-		const ITMHashEntry & blockData(this->scene->index.GetEntries()[visibleEntryIDs[blockNo]]);
+	CreateExpectedDepths_common(this->scene, pose, intrinsics, renderState);
+}
 
-		Vector2i upperLeft, lowerRight;
-		Vector2f zRange;
-		bool validProjection = false;
-		if (blockData.ptr>=0) {
-			validProjection = ProjectSingleBlock(blockData.pos, pose->GetM(), intrinsics->projectionParamsSimple.all, imgSize, voxelSize, upperLeft, lowerRight, zRange);
-		}
-		if (!validProjection) continue;
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	ITMRenderState *renderState) const
+{
+	CreateExpectedDepths_common(this->scene, pose, intrinsics, renderState);
+}
 
-		Vector2i requiredRenderingBlocks((int)ceilf((float)(lowerRight.x - upperLeft.x + 1) / (float)renderingBlockSizeX), 
-			(int)ceilf((float)(lowerRight.y - upperLeft.y + 1) / (float)renderingBlockSizeY));
-		int requiredNumBlocks = requiredRenderingBlocks.x * requiredRenderingBlocks.y;
+template<class TVoxel, class TIndex>
+static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i& imgSize, const Matrix4f& invM, Vector4f projParams, const ITMRenderState *renderState)
+{
+	projParams.x = 1.0f / projParams.x;
+	projParams.y = 1.0f / projParams.y;
 
-		if (numRenderingBlocks + requiredNumBlocks >= MAX_RENDERING_BLOCKS) continue;
-		int offset = numRenderingBlocks;
-		numRenderingBlocks += requiredNumBlocks;
+	const Vector2f *minmaximg = renderState->renderingRangeImage->GetData(MEMORYDEVICE_CPU);
+	float mu = scene->sceneParams->mu;
+	float oneOverVoxelSize = 1.0f / scene->sceneParams->voxelSize;
+	Vector4f *pointsRay = renderState->raycastResult->GetData(MEMORYDEVICE_CPU);
+	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
 
-		CreateRenderingBlocks(&(renderingBlocks[0]), offset, upperLeft, lowerRight, zRange);
-	}
+	// The rays are cast in tiles of the size of the GPU rendering blocks. The pixels of a tile are
+	// close in the range image and mostly hit the same voxel blocks, and as the cost of the tiles
+	// varies a lot (empty space is skipped quickly), they are scheduled dynamically.
+	int noTilesX = (imgSize.x + renderingBlockSizeX - 1) / renderingBlockSizeX;
+	int noTilesY = (imgSize.y + renderingBlockSizeY - 1) / renderingBlockSizeY;
 
-	// go through rendering blocks
-	for (int blockNo = 0; blockNo < numRenderingBlocks; ++blockNo) {
-		// fill minmaxData
-		const RenderingBlock & b(renderingBlocks[blockNo]);
+#ifdef WITH_OPENMP
+	#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int tileId = 0; tileId < noTilesX * noTilesY; ++tileId)
+	{
+		int tileY = tileId / noTilesX, tileX = tileId - tileY * noTilesX;
+		int xBegin = tileX * renderingBlockSizeX, xEnd = MIN(xBegin + renderingBlockSizeX, imgSize.x);
+		int yBegin = tileY * renderingBlockSizeY, yEnd = MIN(yBegin + renderingBlockSizeY, imgSize.y);
 
-		for (int y = b.upperLeft.y; y <= b.lowerRight.y; ++y) {
-			for (int x = b.upperLeft.x; x <= b.lowerRight.x; ++x) {
-				Vector2f & pixel(minmaxData[x + y*imgSize.x]);
-				if (pixel.x > b.zRange.x) pixel.x = b.zRange.x;
-				if (pixel.y < b.zRange.y) pixel.y = b.zRange.y;
-			}
+		for (int y = yBegin; y < yEnd; ++y) for (int x = xBegin; x < xEnd; ++x)
+		{
+			int locId = x + y * imgSize.x;
+			int locId2 = (int)floor((float)x / minmaximg_subsample) + (int)floor((float)y / minmaximg_subsample) * imgSize.x;
+
+			castRay<TVoxel, TIndex>(
+				pointsRay[locId],
+				x, y,
+				voxelData,
+				voxelIndex,
+				invM,
+				projParams,
+				oneOverVoxelSize,
+				mu,
+				minmaximg[locId2]
+			);
 		}
 	}
-	 */
 }
 
+/// \brief Raycasts the pixels listed in locIds, writing the results to pointsRay. Used to fill in
+///        the pixels which a forward projection of an earlier raycast left uncovered.
 template<class TVoxel, class TIndex>
-static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i& imgSize, const Matrix4f& invM, Vector4f projParams, const ITMRenderState *renderState)
+static void RaycastPixels(const ITMScene<TVoxel,TIndex> *scene, const Vector2i& imgSize, const Matrix4f& invM, Vector4f projParams,
+	const ITMRenderState *renderState, const int *locIds, int noLocIds, Vector4f *pointsRay)
 {
 	projParams.x = 1.0f / projParams.x;
 	projParams.y = 1.0f / projParams.y;
@@ -164,51 +272,164 @@ static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i&
 	const Vector2f *minmaximg = renderState->renderingRangeImage->GetData(MEMORYDEVICE_CPU);
 	float mu = scene->sceneParams->mu;
 	float oneOverVoxelSize = 1.0f / scene->sceneParams->voxelSize;
-	Vector4f *pointsRay = renderState->raycastResult->GetData(MEMORYDEVICE_CPU);
 	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
 
+	// The uncovered pixels are few, and some of them (new surfaces) much costlier than the others.
 #ifdef WITH_OPENMP
-	#pragma omp parallel for
+	#pragma omp parallel for schedule(dynamic, 64)
 #endif
-	for (int locId = 0; locId < imgSize.x*imgSize.y; ++locId)
+	for (int pointId = 0; pointId < noLocIds; ++pointId)
 	{
-		int y = locId/imgSize.x;
-		int x = locId - y*imgSize.x;
+		int locId = locIds[pointId];
+		int y = locId / imgSize.x, x = locId - y * imgSize.x;
 		int locId2 = (int)floor((float)x / minmaximg_subsample) + (int)floor((float)y / minmaximg_subsample) * imgSize.x;
 
-		castRay<TVoxel, TIndex>(
-			pointsRay[locId],
-			x, y,
-			voxelData,
-			voxelIndex,
-			invM,
-			projParams,
-			oneOverVoxelSize,
-			mu,
-			minmaximg[locId2]
-		);
+		castRay<TVoxel, TIndex>(pointsRay[locId], x, y, voxelData, voxelIndex, invM, projParams, oneOverVoxelSize,
+			mu, minmaximg[locId2]);
 	}
 }
 
+/// \brief Raycasts the image at a lower resolution, if the settings ask for it, and upsamples the
+///        result, otherwise raycasts every pixel with GenericRaycast.
+///
+///        Every raycastSubsampling-th pixel is raycast (plus the last row and column), and the
+///        depth of the other pixels is interpolated from the four samples around them, with
+///        bilinear weights scaled down for samples far in depth from the nearest one (a joint
+///        bilateral filter guided by the samples' depths). The interpolated point is put on the
+///        ray of its pixel. Pixels whose samples straddle a depth discontinuity (a relative depth
+///        difference above raycastDiscontinuityThreshold per pixel between the samples), or a
+///        silhouette, are raycast instead.
+///        The normals used for shading and ICP are computed from the upsampled points.
 template<class TVoxel, class TIndex>
-static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPose *pose, const ITMIntrinsics *intrinsics, 
-	const ITMRenderState *renderState, ITMUChar4Image *outputImage, ITMFloatImage *, IITMVisualisationEngine::RenderImageType type)
+static void AdaptiveRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i& imgSize, const Matrix4f& invM,
+	const Vector4f &projParams, const ITMRenderState *renderState, const ITMLibSettings *settings)
 {
-	Vector2i imgSize = outputImage->noDims;
-	Matrix4f invM = pose->GetInvM();
+	int step = settings->raycastSubsampling;
+	if (step <= 1)
+	{
+		GenericRaycast(scene, imgSize, invM, projParams, renderState);
+		return;
+	}
+
+	Vector4f *pointsRay = renderState->raycastResult->GetData(MEMORYDEVICE_CPU);
+	int *locIds = renderState->fwdProjMissingPoints->GetData(MEMORYDEVICE_CPU);
+	float voxelSize = scene->sceneParams->voxelSize;
+	float oneOverVoxelSize = 1.0f / voxelSize;
+	float threshold = settings->raycastDiscontinuityThreshold;
+	Matrix4f M; invM.inv(M);
+
+	// The samples are every step-th pixel of every step-th row, plus the last ones, so that every
+	// pixel lies between samples.
+	auto isSample = [=](int x, int y) {
+		return (x % step == 0 || x == imgSize.x - 1) && (y % step == 0 || y == imgSize.y - 1);
+	};
+
+	int noSamples = ORUtils::compactIndices(imgSize.x * imgSize.y,
+		[=](int locId) { return isSample(locId % imgSize.x, locId / imgSize.x); }, locIds);
+	RaycastPixels(scene, imgSize, invM, projParams, renderState, locIds, noSamples, pointsRay);
+
+	// Fills in the other pixels where possible, and lists those which need a ray of their own.
+	int noRecastPixels = ORUtils::compactIndices(imgSize.x * imgSize.y,
+		[=](int locId) {
+			int y = locId / imgSize.x, x = locId - y * imgSize.x;
+			if (isSample(x, y)) return false;
+
+			int x0 = x - x % step, y0 = y - y % step;
+			int x1 = MIN(x0 + step, imgSize.x - 1), y1 = MIN(y0 + step, imgSize.y - 1);
+			float fx = (x1 > x0) ? (float)(x - x0) / (x1 - x0) : 0.0f;
+			float fy = (y1 > y0) ? (float)(y - y0) / (y1 - y0) : 0.0f;
+
+			const int sampleIds[4] = { x0 + y0 * imgSize.x, x1 + y0 * imgSize.x, x0 + y1 * imgSize.x, x1 + y1 * imgSize.x };
+			const float spatialWeights[4] = { (1.0f - fx) * (1.0f - fy), fx * (1.0f - fy), (1.0f - fx) * fy, fx * fy };
+
+			float depths[4];
+			int noHits = 0, nearest = 0;
+			float minDepth = FAR_AWAY, maxDepth = 0.0f;
+			for (int i = 0; i < 4; i++)
+			{
+				Vector4f sample = pointsRay[sampleIds[i]];
+				depths[i] = -1.0f;
+				if (sample.w <= 0) continue;
+
+				depths[i] = (M * Vector4f(sample.x * voxelSize, sample.y * voxelSize, sample.z * voxelSize, 1.0f)).z;
+				minDepth = MIN(minDepth, depths[i]);
+				maxDepth = MAX(maxDepth, depths[i]);
+				if (depths[nearest] < 0.0f || spatialWeights[i] > spatialWeights[nearest]) nearest = i;
+				noHits++;
+			}
 
-	GenericRaycast(scene, imgSize, invM, intrinsics->projectionParamsSimple.all, renderState);
+			if (noHits == 0)
+			{
+				pointsRay[locId] = Vector4f(0.0f, 0.0f, 0.0f, 0.0f);
+				return false;
+			}
+			if (noHits < 4 || maxDepth - minDepth > threshold * minDepth * step) return true;
+
+			// Joint bilateral weights, guided by the depth of the nearest sample.
+			float sigma = 0.5f * threshold * step * depths[nearest];
+			float depth = 0.0f, sumWeights = 0.0f;
+			for (int i = 0; i < 4; i++)
+			{
+				float diff = depths[i] - depths[nearest];
+				float weight = spatialWeights[i] * expf(-diff * diff / (2.0f * sigma * sigma));
+				depth += weight * depths[i];
+				sumWeights += weight;
+			}
+			depth /= sumWeights;
+
+			Vector4f pt_camera(depth * (x - projParams.z) / projParams.x, depth * (y - projParams.w) / projParams.y, depth, 1.0f);
+			Vector4f pt_world = invM * pt_camera;
+			pointsRay[locId] = Vector4f(pt_world.x * oneOverVoxelSize, pt_world.y * oneOverVoxelSize, pt_world.z * oneOverVoxelSize, 1.0f);
+			return false;
+		}, locIds);
+	RaycastPixels(scene, imgSize, invM, projParams, renderState, locIds, noRecastPixels, pointsRay);
+}
 
-	Vector3f lightSource = -Vector3f(invM.getColumn(2));
-	Vector4u *outRendering = outputImage->GetData(MEMORYDEVICE_CPU);
+/// \brief The size of the image to render, which either of the outputs may give.
+static Vector2i GetOutputSize(const ITMUChar4Image *outputCharImage, const ITMFloatImage *outputFloatImage)
+{
+	if (outputCharImage != NULL) return outputCharImage->noDims;
+	if (outputFloatImage != NULL) return outputFloatImage->noDims;
+	throw std::runtime_error("Rendering an image requires an output image.");
+}
+
+/// \brief Shades the raycast in the render state, as seen from the camera pose. Depth maps are
+///        written to the float image, in metres (0 where no surface was found), and all the other
+///        render types to the RGBA image.
+template<class TVoxel, class TIndex>
+static void ShadeImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPose *pose, const ITMRenderState *renderState,
+	ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type)
+{
+	Vector2i imgSize = GetOutputSize(outputCharImage, outputFloatImage);
+	Matrix4f M = pose->GetM();
+	Vector3f lightSource = -Vector3f(pose->GetInvM().getColumn(2));
 	Vector4f *pointsRay = renderState->raycastResult->GetData(MEMORYDEVICE_CPU);
 	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
+	float voxelSize = scene->sceneParams->voxelSize;
 
 	if ((type == IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME)&&
 	    (!TVoxel::hasColorInformation)) type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE;
 
+	if (type == IITMVisualisationEngine::RENDER_DEPTH_MAP) {
+		if (outputFloatImage == NULL) throw std::runtime_error("Depth maps are rendered into a float image.");
+
+		float *outFloatRendering = outputFloatImage->GetData(MEMORYDEVICE_CPU);
+#ifdef WITH_OPENMP
+		#pragma omp parallel for
+#endif
+		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+		{
+			Vector4f ptRay = pointsRay[locId];
+			processPixelColourDepth<TVoxel, TIndex>(outFloatRendering[locId], ptRay.toVector3(), ptRay.w > 0, M, voxelSize);
+		}
+		return;
+	}
+
+	if (outputCharImage == NULL) throw std::runtime_error("This render type needs an RGBA output image.");
+	Vector4u *outRendering = outputCharImage->GetData(MEMORYDEVICE_CPU);
+
 	switch (type) {
 	case IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME:
 #ifdef WITH_OPENMP
@@ -230,10 +451,21 @@ static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPo
 			processPixelNormal<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource);
 		}
 		break;
-
-		case IITMVisualisationEngine::RENDER_COLOUR_FROM_DEPTH_WEIGHT:
-		case IITMVisualisationEngine::RENDER_DEPTH_MAP:
-			throw std::runtime_error("Unsupported render mode for the CPU renderer (which lagged behind the CUDA one).");
+	case IITMVisualisationEngine::RENDER_COLOUR_FROM_DEPTH_WEIGHT: {
+		// Same parameters as the CUDA engine.
+		int maxNoiseWeight = 2;
+		WeightRenderingParams params(1.0, false, scene->sceneParams->maxW, maxNoiseWeight);
+#ifdef WITH_OPENMP
+		#pragma omp parallel for
+#endif
+		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+		{
+			Vector4f ptRay = pointsRay[locId];
+			processPixelColourWeight<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex,
+				lightSource, params);
+		}
+		break;
+	}
 
 	case IITMVisualisationEngine::RENDER_SHADED_GREYSCALE:
 	default:
@@ -248,6 +480,120 @@ static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPo
 	}
 }
 
+template<class TVoxel, class TIndex>
+static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	const ITMRenderState *renderState, ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage,
+	IITMVisualisationEngine::RenderImageType type, const ITMLibSettings *settings)
+{
+	AdaptiveRaycast(scene, GetOutputSize(outputCharImage, outputFloatImage), pose->GetInvM(),
+		intrinsics->projectionParamsSimple.all, renderState, settings);
+	ShadeImage_common(scene, pose, renderState, outputCharImage, outputFloatImage, type);
+}
+
+/// \brief Whether the raycast of an earlier incremental render can be forward projected into the
+///        view of the camera M, instead of raycasting the view from scratch. The camera motion is
+///        measured from the last full raycast, so that small steps cannot add up, and the scene
+///        must not have changed since then.
+static bool CanReuseRaycast(const ITMRenderState *renderState, const ITMLibSettings *settings, const Matrix4f &M,
+	const Vector4f &projParams, const Vector2i &imgSize, unsigned int sceneVersion)
+{
+	if (renderState->noIncrementalUpdates < 0 ||
+		renderState->noIncrementalUpdates >= settings->incrementalRenderingRefreshInterval) return false;
+	if (renderState->raycastResult->noDims != imgSize || renderState->incrementalProjParams != projParams) return false;
+	if (renderState->incrementalSceneVersion != sceneVersion) return false;
+
+	// Maps the camera of the full raycast to the new one, so its translation is the position of
+	// the old camera centre in the new frame, and its trace gives the angle of the rotation in
+	// between.
+	Matrix4f relative = M * renderState->incrementalInvM;
+	Vector3f translation(relative.m[12], relative.m[13], relative.m[14]);
+	float cosAngle = (relative.m[0] + relative.m[5] + relative.m[10] - 1.0f) * 0.5f;
+
+	return length(translation) <= settings->incrementalRenderingMaxTranslation &&
+		cosAngle >= cosf(settings->incrementalRenderingMaxRotation);
+}
+
+template<class TVoxel, class TIndex>
+static void RenderImageIncremental_common(const IITMVisualisationEngine *engine, const ITMScene<TVoxel,TIndex> *scene,
+	const ITMLibSettings *settings, const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState,
+	ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type)
+{
+	Vector2i imgSize = GetOutputSize(outputCharImage, outputFloatImage);
+	Matrix4f M = pose->GetM(), invM = pose->GetInvM();
+	Vector4f projParams = intrinsics->projectionParamsSimple.all;
+
+	// The range image is still needed for the pixels which get raycast, and is cheap to compute.
+	engine->FindVisibleBlocks(pose, intrinsics, renderState);
+	engine->CreateExpectedDepths(pose, intrinsics, renderState);
+
+	unsigned int sceneVersion = scene->localVBA.GetVersion();
+	if (!CanReuseRaycast(renderState, settings, M, projParams, imgSize, sceneVersion))
+	{
+		GenericRaycast(scene, imgSize, invM, projParams, renderState);
+		renderState->incrementalInvM = invM;
+		renderState->incrementalProjParams = projParams;
+		renderState->incrementalSceneVersion = sceneVersion;
+		renderState->noIncrementalUpdates = 0;
+	}
+	else
+	{
+		const Vector4f *pointsRay = renderState->raycastResult->GetData(MEMORYDEVICE_CPU);
+		Vector4f *forwardProjection = renderState->forwardProjection->GetData(MEMORYDEVICE_CPU);
+		int *fwdProjMissingPoints = renderState->fwdProjMissingPoints->GetData(MEMORYDEVICE_CPU);
+		const Vector2f *minmaximg = renderState->renderingRangeImage->GetData(MEMORYDEVICE_CPU);
+		float voxelSize = scene->sceneParams->voxelSize;
+		int noTotalPixels = imgSize.x * imgSize.y;
+
+		renderState->forwardProjection->Clear();
+		std::vector<float> forwardDepth(noTotalPixels, FAR_AWAY);
+
+		// Serial, so that the point nearest to the new camera wins every pixel without any locking.
+		for (int locId = 0; locId < noTotalPixels; locId++)
+		{
+			Vector4f point = pointsRay[locId];
+			if (point.w <= 0) continue;
+
+			Vector4f pt_camera = M * Vector4f(point.x * voxelSize, point.y * voxelSize, point.z * voxelSize, 1.0f);
+			if (pt_camera.z <= 0) continue;
+
+			Vector2f pt_image;
+			pt_image.x = projParams.x * pt_camera.x / pt_camera.z + projParams.z;
+			pt_image.y = projParams.y * pt_camera.y / pt_camera.z + projParams.w;
+			if (!(pt_image.x >= 0 && pt_image.x <= imgSize.x - 1 && pt_image.y >= 0 && pt_image.y <= imgSize.y - 1)) continue;
+
+			int locId_new = (int)(pt_image.x + 0.5f) + (int)(pt_image.y + 0.5f) * imgSize.x;
+			if (pt_camera.z < forwardDepth[locId_new])
+			{
+				forwardDepth[locId_new] = pt_camera.z;
+				forwardProjection[locId_new] = point;
+			}
+		}
+
+		// The pixels no point landed on are either disoccluded, new, or saw no surface last time.
+		int noMissingPoints = 0;
+		for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
+		{
+			int locId = x + y * imgSize.x;
+			int locId2 = (int)floor((float)x / minmaximg_subsample) + (int)floor((float)y / minmaximg_subsample) * imgSize.x;
+			Vector2f minmaxval = minmaximg[locId2];
+
+			if (forwardProjection[locId].w <= 0 && minmaxval.x < minmaxval.y)
+			{
+				fwdProjMissingPoints[noMissingPoints] = locId;
+				noMissingPoints++;
+			}
+		}
+		renderState->noFwdProjMissingPoints = noMissingPoints;
+
+		RaycastPixels(scene, imgSize, invM, projParams, renderState, fwdProjMissingPoints, noMissingPoints, forwardProjection);
+
+		renderState->raycastResult->SetFrom(renderState->forwardProjection, ORUtils::MemoryBlock<Vector4f>::CPU_TO_CPU);
+		renderState->noIncrementalUpdates++;
+	}
+
+	ShadeImage_common(scene, pose, renderState, outputCharImage, outputFloatImage, type);
+}
+
 template<class TVoxel, class TIndex>
 static void CreatePointCloud_common(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, 
 	ITMRenderState *renderState, bool skipPoints)
@@ -273,12 +619,13 @@ static void CreatePointCloud_common(const ITMScene<TVoxel,TIndex> *scene, const
 }
 
 template<class TVoxel, class TIndex>
-static void CreateICPMaps_common(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState)
+static void CreateICPMaps_common(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState,
+	const ITMLibSettings *settings)
 {
 	Vector2i imgSize = renderState->raycastResult->noDims;
 	Matrix4f invM = trackingState->pose_d->GetInvM();
 
-	GenericRaycast(scene, imgSize, invM, view->calib->intrinsics_d.projectionParamsSimple.all, renderState);
+	AdaptiveRaycast(scene, imgSize, invM, view->calib->intrinsics_d.projectionParamsSimple.all, renderState, settings);
 	trackingState->pose_pointCloud->SetFrom(trackingState->pose_d);
 
 	Vector3f lightSource = -Vector3f(invM.getColumn(2));
@@ -366,14 +713,49 @@ template<class TVoxel, class TIndex>
 void ITMVisualisationEngine_CPU<TVoxel,TIndex>::RenderImage(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
 	const ITMRenderState *renderState, ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type) const
 {
-	RenderImage_common(this->scene, pose, intrinsics, renderState, outputCharImage, outputFloatImage, type);
+	RenderImage_common(this->scene, pose, intrinsics, renderState, outputCharImage, outputFloatImage, type,
+		this->settings);
 }
 
 template<class TVoxel>
 void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::RenderImage(const ITMPose *pose,  const ITMIntrinsics *intrinsics, 
 	const ITMRenderState *renderState, ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type) const
 {
-	RenderImage_common(this->scene, pose, intrinsics, renderState, outputCharImage, outputFloatImage, type);
+	RenderImage_common(this->scene, pose, intrinsics, renderState, outputCharImage, outputFloatImage, type,
+		this->settings);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::RenderImage(const ITMPose *pose,  const ITMIntrinsics *intrinsics, 
+	const ITMRenderState *renderState, ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type) const
+{
+	RenderImage_common(this->scene, pose, intrinsics, renderState, outputCharImage, outputFloatImage, type,
+		this->settings);
+}
+
+
+template<class TVoxel, class TIndex>
+void ITMVisualisationEngine_CPU<TVoxel,TIndex>::RenderImageIncremental(const ITMPose *pose, const ITMIntrinsics *intrinsics,
+	ITMRenderState *renderState, ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type) const
+{
+	RenderImageIncremental_common(this, this->scene, this->settings, pose, intrinsics, renderState, outputCharImage,
+		outputFloatImage, type);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::RenderImageIncremental(const ITMPose *pose, const ITMIntrinsics *intrinsics,
+	ITMRenderState *renderState, ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type) const
+{
+	RenderImageIncremental_common(this, this->scene, this->settings, pose, intrinsics, renderState, outputCharImage,
+		outputFloatImage, type);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::RenderImageIncremental(const ITMPose *pose, const ITMIntrinsics *intrinsics,
+	ITMRenderState *renderState, ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type) const
+{
+	RenderImageIncremental_common(this, this->scene, this->settings, pose, intrinsics, renderState, outputCharImage,
+		outputFloatImage, type);
 }
 
 template<class TVoxel, class TIndex>
@@ -389,6 +771,13 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::FindSurface(const ITM
 	GenericRaycast(this->scene, renderState->raycastResult->noDims, pose->GetInvM(), intrinsics->projectionParamsSimple.all, renderState);
 }
 
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	const ITMRenderState *renderState) const
+{
+	GenericRaycast(this->scene, renderState->raycastResult->noDims, pose->GetInvM(), intrinsics->projectionParamsSimple.all, renderState);
+}
+
 template<class TVoxel, class TIndex>
 void ITMVisualisationEngine_CPU<TVoxel,TIndex>::CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, 
 	ITMRenderState *renderState, bool skipPoints) const
@@ -403,17 +792,31 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreatePointCloud(cons
 	CreatePointCloud_common(this->scene, view, trackingState, renderState, skipPoints);
 }
 
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, 
+	ITMRenderState *renderState, bool skipPoints) const
+{
+	CreatePointCloud_common(this->scene, view, trackingState, renderState, skipPoints);
+}
+
 template<class TVoxel, class TIndex>
 void ITMVisualisationEngine_CPU<TVoxel,TIndex>::CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const
 {
-	CreateICPMaps_common(this->scene, view, trackingState, renderState);
+	CreateICPMaps_common(this->scene, view, trackingState, renderState, this->settings);
 }
 
 template<class TVoxel>
 void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, 
 	ITMRenderState *renderState) const
 {
-	CreateICPMaps_common(this->scene, view, trackingState, renderState);
+	CreateICPMaps_common(this->scene, view, trackingState, renderState, this->settings);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, 
+	ITMRenderState *renderState) const
+{
+	CreateICPMaps_common(this->scene, view, trackingState, renderState, this->settings);
 }
 
 template<class TVoxel, class TIndex>
@@ -430,6 +833,13 @@ void ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockHash>::ForwardRender(const
 	ForwardRender_common(this->scene, view, trackingState, renderState);
 }
 
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::ForwardRender(const ITMView *view, ITMTrackingState *trackingState,
+	ITMRenderState *renderState) const
+{
+	ForwardRender_common(this->scene, view, trackingState, renderState);
+}
+
 template<class TVoxel, class TIndex>
 static int RenderPointCloud(Vector4u *outRendering, Vector4f *locations, Vector4f *colours, const Vector4f *ptsRay, 
 	const TVoxel *voxelData, const typename TIndex::IndexData *voxelIndex, bool skipPoints, float voxelSize, 
@@ -471,3 +881,6 @@ static int RenderPointCloud(Vector4u *outRendering, Vector4f *locations, Vector4
 }
 
 template class ITMLib::Engine::ITMVisualisationEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+#if ITM_VOXEL_INDEX != ITM_VOXEL_INDEX_OPEN_HASH
+template class ITMLib::Engine::ITMVisualisationEngine_CPU<ITMVoxel, ITMVoxelBlockOpenHash>;
+#endif
@@ -12,13 +12,16 @@ namespace ITMLib
 		class ITMVisualisationEngine_CPU : public ITMVisualisationEngine < TVoxel, TIndex >
 		{
 		public:
-			explicit ITMVisualisationEngine_CPU(ITMScene<TVoxel, TIndex> *scene) : ITMVisualisationEngine<TVoxel, TIndex>(scene) { }
+			ITMVisualisationEngine_CPU(ITMScene<TVoxel, TIndex> *scene, const ITMLibSettings *settings)
+				: ITMVisualisationEngine<TVoxel, TIndex>(scene, settings) { }
 			~ITMVisualisationEngine_CPU(void) { }
 
 			void FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const;
 			void CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const;
 			void RenderImage(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState, 
 				ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE) const;
+			void RenderImageIncremental(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState,
+				ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE) const;
 			void FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState) const;
 			void CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState, bool skipPoints) const;
 			void CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const;
@@ -41,6 +44,32 @@ namespace ITMLib
 			void CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const;
 			void RenderImage(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState, 
 				ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE) const;
+			void RenderImageIncremental(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState,
+				ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE) const;
+			void FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState) const;
+			void CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState, bool skipPoints) const;
+			void CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const;
+			void ForwardRender(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const;
+
+			ITMRenderState_VH* CreateRenderState(const Vector2i & imgSize) const;
+		};
+
+		template<class TVoxel>
+		class ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockOpenHash> : public ITMVisualisationEngine < TVoxel, ITMVoxelBlockOpenHash >
+		{
+		public:
+			explicit ITMVisualisationEngine_CPU(
+					ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene,
+					const ITMLibSettings *settings)
+				: ITMVisualisationEngine<TVoxel, ITMVoxelBlockOpenHash>(scene, settings) { }
+			~ITMVisualisationEngine_CPU(void) { }
+
+			void FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const;
+			void CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const;
+			void RenderImage(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState, 
+				ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE) const;
+			void RenderImageIncremental(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState,
+				ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage, IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE) const;
 			void FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState) const;
 			void CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState, bool skipPoints) const;
 			void CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const;
@@ -9,7 +9,7 @@
 
 template<class TVoxel>
 __global__ void meshScene_device(ITMMesh::Triangle *triangles, unsigned int *noTriangles_device, float factor, int noTotalEntries,
-	int noMaxTriangles, const Vector4s *visibleBlockGlobalPos, const TVoxel *localVBA, const ITMHashEntry *hashTable);
+	int noMaxTriangles, const Vector4s *visibleBlockGlobalPos, const TVoxel *localVBA, const ITMVoxelBlockHash::IndexData *voxelIndex);
 
 using namespace ITMLib::Engine;
 
@@ -69,7 +69,7 @@ void ITMMeshingEngine_CUDA<TVoxel, ITMVoxelBlockHash>::MeshScene(ITMMesh *mesh,
 				noMaxTriangles,
 				visibleBlockGlobalPos_device,
 				localVBA,
-				hashTable);
+				scene->index.getIndexData());
 
 		ITMSafeCall(cudaMemcpy(
 				&mesh->noTotalTriangles,
@@ -115,7 +115,7 @@ __global__ void ITMLib::Engine::findAllocatedBlocks(
 
 template<class TVoxel>
 __global__ void meshScene_device(ITMMesh::Triangle *triangles, unsigned int *noTriangles_device, float factor, int noTotalEntries, 
-	int noMaxTriangles, const Vector4s *visibleBlockGlobalPos, const TVoxel *localVBA, const ITMHashEntry *hashTable)
+	int noMaxTriangles, const Vector4s *visibleBlockGlobalPos, const TVoxel *localVBA, const ITMVoxelBlockHash::IndexData *voxelIndex)
 {
 	const Vector4s globalPos_4s = visibleBlockGlobalPos[blockIdx.x + gridDim.x * blockIdx.y];
 
@@ -126,7 +126,7 @@ __global__ void meshScene_device(ITMMesh::Triangle *triangles, unsigned int *noT
 	Vector3f vertList[12];
 
 	Vector3i localPos = Vector3i(threadIdx.x, threadIdx.y, threadIdx.z);
-	int cubeIndex = buildVertList(vertList, globalPos, localPos, localVBA, hashTable);
+	int cubeIndex = buildVertList(vertList, globalPos, localPos, localVBA, voxelIndex);
 
 	if (cubeIndex < 0) return;
 
@@ -146,17 +146,17 @@ __global__ void meshScene_device(ITMMesh::Triangle *triangles, unsigned int *noT
 			Vector3f c0 =
 					VoxelColorReader<TVoxel::hasColorInformation, TVoxel, ITMVoxelBlockHash>::interpolate3(
 							localVBA,
-							hashTable,
+							voxelIndex,
                             p0);
 			Vector3f c1 =
 					VoxelColorReader<TVoxel::hasColorInformation, TVoxel, ITMVoxelBlockHash>::interpolate3(
 							localVBA,
-							hashTable,
+							voxelIndex,
                             p1);
 			Vector3f c2 =
 					VoxelColorReader<TVoxel::hasColorInformation, TVoxel, ITMVoxelBlockHash>::interpolate3(
 							localVBA,
-							hashTable,
+							voxelIndex,
                             p2);
 
 			triangles[triangleId].c0 = c0;
@@ -16,7 +16,7 @@ using namespace ITMLib::Engine;
 
 template<class TVoxel, bool stopMaxW, bool approximateIntegration>
 __global__ void integrateIntoScene_device(TVoxel *localVBA,
-										  const ITMHashEntry *hashTable,
+										  const ITMVoxelBlockHash::IndexData *voxelIndex,
 										  Vector3i *visibleBlockPositions,
 										  const Vector4u *rgb,
 										  Vector2i rgbImgSize,
@@ -37,13 +37,14 @@ __global__ void integrateIntoScene_device(TVoxel *voxelArray, const ITMPlainVoxe
 	Vector4f projParams_rgb, float _voxelSize, float mu, int maxW);
 
 __global__ void buildHashAllocAndVisibleType_device(uchar *entriesAllocType, uchar *entriesVisibleType, Vector4s *blockCoords, const float *depth,
-	Matrix4f invM_d, Vector4f projParams_d, float mu, Vector2i _imgSize, float _voxelSize, ITMHashEntry *hashTable, float viewFrustum_min,
+	Matrix4f invM_d, Vector4f projParams_d, float mu, Vector2i _imgSize, float _voxelSize, const ITMVoxelBlockHash::IndexData *voxelIndex, float viewFrustum_min,
 	float viewFrustrum_max, int *locks);
 
 __global__ void allocateVoxelBlocksList_device(int *voxelAllocationList,
 											   int *excessAllocationList,
 											   ITMHashEntry *hashTable,
 											   int noTotalEntries,
+											   int bucketNum,
 											   AllocationTempData *allocData,
 											   uchar *entriesAllocType,
 											   uchar *entriesVisibleType,
@@ -56,7 +57,7 @@ __global__ void reAllocateSwappedOutVoxelBlocks_device(int *voxelAllocationList,
 __global__ void setToType3(uchar *entriesVisibleType,
 						   Vector3i *visibleBlockPositions,
 						   int noVisibleBlocks,
-						   ITMHashEntry *hashTable);
+						   const ITMVoxelBlockHash::IndexData *voxelIndex);
 
 template<bool useSwapping>
 __global__ void buildVisibleList_device(ITMHashEntry *hashTable, ITMHashSwapState *swapStates, int noTotalBlocks,
@@ -67,7 +68,7 @@ __global__ void buildVisibleList_device(ITMHashEntry *hashTable, ITMHashSwapStat
 ///        empty in the process as pending deallocation in `outBlocksToDeallocate`.
 /// \tparam TVoxel The type of voxel representation to operate on (grayscale/color, float/short, etc.)
 /// \param localVBA The raw storage where the hash map entries reside.
-/// \param hashTable Maps entry IDs to addresses in the local VBA.
+/// \param voxelIndex The hash table, which maps entry IDs to addresses in the local VBA.
 /// \param visibleBlockPositions A list of blocks on which to operate (typically, this is the list
 ///                              containing the visible blocks $k$ frames ago). The size of the list
 ///                              should be known in advance, and be implicitly range-checked by
@@ -83,7 +84,7 @@ __global__ void buildVisibleList_device(ITMHashEntry *hashTable, ITMHashSwapStat
 ///                           block is visible.
 template<class TVoxel>
 __global__ void decay_device(TVoxel *localVBA,
-							 ITMHashEntry *hashTable,
+							 const ITMVoxelBlockHash::IndexData *voxelIndex,
 							 Vector3i *visibleBlockPositions,
 							 int minAge,
 							 int maxWeight,
@@ -100,7 +101,7 @@ template<class TVoxel>
 __global__ void decayFull_device(
 		const Vector4s *usedBlockPositions,
 		TVoxel *localVBA,
-		ITMHashEntry *hashTable,
+		const ITMVoxelBlockHash::IndexData *voxelIndex,
 		int minAge,
 		int maxWeight,
 		int *voxelAllocationList,
@@ -114,17 +115,20 @@ __global__ void decayFull_device(
 
 template<class TVoxel>
 ITMSceneReconstructionEngine_CUDA<TVoxel,ITMVoxelBlockHash>::ITMSceneReconstructionEngine_CUDA(
-		long sdfLocalBlockNum
-) {
+		long sdfLocalBlockNum,
+		long sdfBucketNum,
+		long sdfExcessListSize
+) : sdfBucketNum(sdfBucketNum), sdfExcessListSize(sdfExcessListSize)
+{
 	ITMSafeCall(cudaMalloc((void**)&allocationTempData_device, sizeof(AllocationTempData)));
 	ITMSafeCall(cudaMallocHost((void**)&allocationTempData_host, sizeof(AllocationTempData)));
 
-	int noTotalEntries = ITMVoxelBlockHash::noTotalEntries;
+	int noTotalEntries = sdfBucketNum + sdfExcessListSize;
 	ITMSafeCall(cudaMalloc((void**)&entriesAllocType_device, noTotalEntries));
 	ITMSafeCall(cudaMalloc((void**)&blockCoords_device, noTotalEntries * sizeof(Vector4s)));
 
 	ITMSafeCall(cudaMalloc((void**)&lastFreeBlockId_device, 1 * sizeof(int)));
-	ITMSafeCall(cudaMalloc(&locks_device, SDF_BUCKET_NUM * sizeof(int)));
+	ITMSafeCall(cudaMalloc(&locks_device, sdfBucketNum * sizeof(int)));
 	ITMSafeCall(cudaMalloc((void**)&allocatedBlockPositions_device, sdfLocalBlockNum * sizeof(Vector4s)));
 }
 
@@ -165,10 +169,11 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel,ITMVoxelBlockHash>::ResetScene(ITM
 	tmpEntry.ptr = -2;
 	ITMHashEntry *hashEntry_ptr = scene->index.GetEntries();
 	memsetKernel<ITMHashEntry>(hashEntry_ptr, tmpEntry, scene->index.noTotalEntries);
+	int excessListSize = scene->index.getExcessListSize();
 	int *excessList_ptr = scene->index.GetExcessAllocationList();
-	fillArrayKernel<int>(excessList_ptr, SDF_EXCESS_LIST_SIZE);
+	fillArrayKernel<int>(excessList_ptr, excessListSize);
 
-	scene->index.SetLastFreeExcessListId(SDF_EXCESS_LIST_SIZE - 1);
+	scene->index.SetLastFreeExcessListId(excessListSize - 1);
 }
 
 template<class TVoxel>
@@ -188,6 +193,11 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::AllocateScene
 	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
 	M_d = trackingState->pose_d->GetM(); M_d.inv(invM_d);
 
+	if (scene->index.getBucketNum() != sdfBucketNum || scene->index.getExcessListSize() != sdfExcessListSize) {
+		throw std::runtime_error("The hash table of the scene does not have the size the "
+								 "reconstruction engine was created for.");
+	}
+
 	projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
 	invProjParams_d = projParams_d;
 	invProjParams_d.x = 1.0f / invProjParams_d.x;
@@ -199,6 +209,7 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::AllocateScene
 	int *voxelAllocationList = scene->localVBA.GetAllocationList();
 	int *excessAllocationList = scene->index.GetExcessAllocationList();
 	ITMHashEntry *hashTable = scene->index.GetEntries();
+	const ITMVoxelBlockHash::IndexData *voxelIndex = scene->index.getIndexData();
 	ITMHashSwapState *swapStates = scene->useSwapping ? scene->globalCache->GetSwapStates(true) : 0;
 
 	// The sum of the nr. of buckets, plus and the excess list size.
@@ -240,12 +251,12 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::AllocateScene
 				entriesVisibleType,
 				visibleBlockPositions,
 				renderState_vh->noVisibleBlocks,
-				hashTable);
+				voxelIndex);
 	}
 
-	ITMSafeCall(cudaMemset(locks_device, 0, sizeof(int) * SDF_BUCKET_NUM));
+	ITMSafeCall(cudaMemset(locks_device, 0, sizeof(int) * sdfBucketNum));
 	buildHashAllocAndVisibleType_device << <gridSizeHV, cudaBlockSizeHV >> >(entriesAllocType_device, entriesVisibleType,
-		blockCoords_device, depth, invM_d, invProjParams_d, mu, depthImgSize, oneOverVoxelSize, hashTable,
+		blockCoords_device, depth, invM_d, invProjParams_d, mu, depthImgSize, oneOverVoxelSize, voxelIndex,
 		scene->sceneParams->viewFrustum_min, scene->sceneParams->viewFrustum_max, locks_device);
 
 	bool useSwapping = scene->useSwapping;
@@ -259,6 +270,7 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::AllocateScene
 				voxelAllocationList,
 				excessAllocationList, hashTable,
 				noTotalEntries,
+				sdfBucketNum,
 				(AllocationTempData *) allocationTempData_device,
 				entriesAllocType_device,
 				entriesVisibleType,
@@ -322,7 +334,7 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::AllocateScene
 	// the GPU (for non-swapping case).
 	long usedBlocks = allocatedBlocks - scene->localVBA.lastFreeBlockId - 1;
 
-	long allocatedExcessEntries = SDF_EXCESS_LIST_SIZE;
+	long allocatedExcessEntries = scene->index.getExcessListSize();
 	long usedExcessEntries = allocatedExcessEntries - tempData->noAllocatedExcessEntries;
 
 	if (usedBlocks > allocatedBlocks) {
@@ -388,7 +400,7 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::IntegrateInto
 	float *depth = view->depth->GetData(MEMORYDEVICE_CUDA);
 	Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CUDA);
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
-	ITMHashEntry *hashTable = scene->index.GetEntries();
+	const ITMVoxelBlockHash::IndexData *voxelIndex = scene->index.getIndexData();
 
 	Vector3i *visibleBlockPositions = renderState_vh->GetVisibleBlockPositions();
 
@@ -403,11 +415,11 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::IntegrateInto
 	if (scene->sceneParams->stopIntegratingAtMaxW) {
 		if (trackingState->requiresFullRendering) {
 			integrateIntoScene_device<TVoxel, true, false> <<<visibleBlockGrid, voxelBlockSize>>> (
-				localVBA, hashTable, visibleBlockPositions, rgb, rgbImgSize, depth, depthImgSize,
+				localVBA, voxelIndex, visibleBlockPositions, rgb, rgbImgSize, depth, depthImgSize,
 				M_d, M_rgb, projParams_d, projParams_rgb, voxelSize, mu, maxW, fusionWeightParams);
 		} else {
 			integrateIntoScene_device<TVoxel, true, true> <<<visibleBlockGrid, voxelBlockSize>>> (
-				localVBA, hashTable, visibleBlockPositions, rgb, rgbImgSize, depth, depthImgSize,
+				localVBA, voxelIndex, visibleBlockPositions, rgb, rgbImgSize, depth, depthImgSize,
 				M_d, M_rgb, projParams_d, projParams_rgb, voxelSize, mu, maxW, fusionWeightParams);
 		}
 	}
@@ -415,12 +427,12 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::IntegrateInto
 		if (trackingState->requiresFullRendering) {
 			// While developing dynslam, this is the version that is run.
 			integrateIntoScene_device<TVoxel, false, false> <<<visibleBlockGrid, voxelBlockSize>>> (
-					localVBA, hashTable, visibleBlockPositions, rgb, rgbImgSize, depth, depthImgSize,
+					localVBA, voxelIndex, visibleBlockPositions, rgb, rgbImgSize, depth, depthImgSize,
 						M_d, M_rgb, projParams_d, projParams_rgb, voxelSize, mu, maxW, fusionWeightParams);
 		}
 		else {
 			integrateIntoScene_device<TVoxel, false, true> <<<visibleBlockGrid, voxelBlockSize>>> (
-				localVBA, hashTable, visibleBlockPositions, rgb, rgbImgSize, depth, depthImgSize,
+				localVBA, voxelIndex, visibleBlockPositions, rgb, rgbImgSize, depth, depthImgSize,
 						M_d, M_rgb, projParams_d, projParams_rgb, voxelSize, mu, maxW, fusionWeightParams);
 		}
 	}
@@ -437,6 +449,7 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::FullDecay(
 	int *voxelAllocationList = scene->localVBA.GetAllocationList();
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
 	ITMHashEntry *hashTable = scene->index.GetEntries();
+	const ITMVoxelBlockHash::IndexData *voxelIndex = scene->index.getIndexData();
 
 	// First, we check every bucket and see if it's allocated, populating each index
 	// in `visibleBlockGlobalPos` with the block's position, whereby every element in
@@ -455,11 +468,11 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::FullDecay(
 	// We now know, for every block allocated in the VBA, whether it's in use, and what its
 	// global coordinates are.
 	dim3 gridSize(sdfLocalBlockNum);
-	ITMSafeCall(cudaMemset(locks_device, 0, SDF_BUCKET_NUM * sizeof(int)));
+	ITMSafeCall(cudaMemset(locks_device, 0, sdfBucketNum * sizeof(int)));
 	decayFull_device<TVoxel> <<< gridSize, voxelBlockSize >>> (
 			allocatedBlockPositions_device,
 			localVBA,
-			hashTable,
+			voxelIndex,
 			minAge,
 			maxWeight,
 			voxelAllocationList,
@@ -484,15 +497,15 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::PartialDecay(
 ) {
 	int *voxelAllocationList = scene->localVBA.GetAllocationList();
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
-	ITMHashEntry *hashTable = scene->index.GetEntries();
+	const ITMVoxelBlockHash::IndexData *voxelIndex = scene->index.getIndexData();
 
-	ITMSafeCall(cudaMemset(locks_device, 0, SDF_BUCKET_NUM * sizeof(int)));
+	ITMSafeCall(cudaMemset(locks_device, 0, sdfBucketNum * sizeof(int)));
 
 	dim3 voxelBlockSize(SDF_BLOCK_SIZE, SDF_BLOCK_SIZE, SDF_BLOCK_SIZE);
 	dim3 gridSize(static_cast<uint32_t>(visibleBlockInfo.count));
 	decay_device<TVoxel> <<< gridSize, voxelBlockSize >>> (
 			localVBA,
-			hashTable,
+			voxelIndex,
 			visibleBlockInfo.blockCoords->GetData(MEMORYDEVICE_CUDA),
 			minAge,
 			maxWeight,
@@ -513,6 +526,11 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::Decay(
 		int minAge,
 		bool forceAllVoxels
 ) {
+	if (scene->index.getBucketNum() != sdfBucketNum) {
+		throw std::runtime_error("The hash table of the scene does not have the size the "
+								 "reconstruction engine was created for.");
+	}
+
 	int oldLastFreeBlockId = scene->localVBA.lastFreeBlockId;
 	ITMSafeCall(cudaMemcpy(lastFreeBlockId_device, &(scene->localVBA.lastFreeBlockId),
 						   1 * sizeof(int),
@@ -691,7 +709,7 @@ __global__ void integrateIntoScene_device(TVoxel *voxelArray, const ITMPlainVoxe
 // Runs for every block in the visible list => Needs lookup.
 template<class TVoxel, bool stopMaxW, bool approximateIntegration>
 __global__ void integrateIntoScene_device(TVoxel *localVBA,
-										  const ITMHashEntry *hashTable,
+										  const ITMVoxelBlockHash::IndexData *voxelIndex,
 										  Vector3i *visibleBlockPositions,
 										  const Vector4u *rgb,
 										  Vector2i rgbImgSize,
@@ -706,10 +724,11 @@ __global__ void integrateIntoScene_device(TVoxel *localVBA,
 {
 	Vector3i globalPos;
 	bool isFound = false;
-	int entryId = findBlock(hashTable, visibleBlockPositions[blockIdx.x], isFound);
+	const ITMHashEntry *hashTable = voxelIndex->entries;
+	int entryId = findBlock(voxelIndex, visibleBlockPositions[blockIdx.x], isFound);
 
 	int x = threadIdx.x, y = threadIdx.y, z = threadIdx.z;
-	int locId = x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+	int locId = voxelBlockLocalIdx(x, y, z);
 
 	if (!isFound || entryId < 0) {
 		if (locId == 0) {
@@ -759,7 +778,7 @@ __global__ void buildHashAllocAndVisibleType_device(
 		float mu,
 		Vector2i _imgSize,
 		float _voxelSize,
-		ITMHashEntry *hashTable,
+		const ITMVoxelBlockHash::IndexData *voxelIndex,
 		float viewFrustum_min,
 		float viewFrustum_max,
 		int *locks
@@ -769,14 +788,14 @@ __global__ void buildHashAllocAndVisibleType_device(
 	if (x > _imgSize.x - 1 || y > _imgSize.y - 1) return;
 
 	buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
-		projParams_d, mu, _imgSize, _voxelSize, hashTable, viewFrustum_min, viewFrustum_max, locks);
+		projParams_d, mu, _imgSize, _voxelSize, voxelIndex, viewFrustum_min, viewFrustum_max, locks);
 }
 
 // Runs for every block in the visible list => needs lookup.
 __global__ void setToType3(uchar *entriesVisibleType,
 						   Vector3i *visibleBlockPositions,
 						   int noVisibleBlocks,
-						   ITMHashEntry *hashTable)
+						   const ITMVoxelBlockHash::IndexData *voxelIndex)
 {
 	int entryId = threadIdx.x + blockIdx.x * blockDim.x;
 	if (entryId >= noVisibleBlocks) {
@@ -784,13 +803,13 @@ __global__ void setToType3(uchar *entriesVisibleType,
 	}
 
 	bool isFound = false;
-	int hashIdx = findBlock(hashTable, visibleBlockPositions[entryId], isFound);
+	int hashIdx = findBlock(voxelIndex, visibleBlockPositions[entryId], isFound);
 
 	if (! isFound || hashIdx < 0) {
 		// The block (which was in sight last frame) was cleared out by the decay. Not an error, but
 		// may lead to artifacts in the map. This can happen if the decay "catches up" with the
 		// active reconstruction.
-//      int hashVal = hashIndex(visibleBlocks[entryId]);
+//      int hashVal = hashIndex(visibleBlocks[entryId], voxelIndex->hashMask);
 //		if (hashVal % 100 < 40) {
 //			printf("WARNING in setToType3 visibleBlocks[%d]: (isFound = %d, hashIdx = %d"
 //						   ")! | (%d, %d, %d) @ hashVal = %d\n",
@@ -811,7 +830,7 @@ __global__ void setToType3(uchar *entriesVisibleType,
 
 __global__ void allocateVoxelBlocksList_device(
 		int *voxelAllocationList, int *excessAllocationList,
-		ITMHashEntry *hashTable, int noTotalEntries,
+		ITMHashEntry *hashTable, int noTotalEntries, int bucketNum,
 		AllocationTempData *allocData,
 		uchar *entriesAllocType, uchar *entriesVisibleType,
 		Vector4s *blockCoords,
@@ -871,9 +890,9 @@ __global__ void allocateVoxelBlocksList_device(
 
 			hashTable[targetIdx].offset = exlOffset + 1; //connect to child
 
-			hashTable[SDF_BUCKET_NUM + exlOffset] = hashEntry; //add child to the excess list
+			hashTable[bucketNum + exlOffset] = hashEntry; //add child to the excess list
 
-			entriesVisibleType[SDF_BUCKET_NUM + exlOffset] = 1; //make child visible
+			entriesVisibleType[bucketNum + exlOffset] = 1; //make child visible
 		}
 		else
 		{
@@ -999,7 +1018,7 @@ __global__ void buildVisibleList_device(
 }
 
 /// \brief Deletes a block from the hash table and de-allocates its VBA entry.
-/// \param hashTable
+/// \param voxelIndex           The hash table.
 /// \param blockPos             The position of the block in the voxel grid, i.e., the key.
 /// \param locks                Array used for locking in order to prevent data races when
 ///                             attempting to delete multiple elements with the same key.
@@ -1012,14 +1031,15 @@ __global__ void buildVisibleList_device(
 template<class TVoxel, bool paranoid=false>
 __device__
 void deleteBlock(
-		ITMHashEntry *hashTable,
+		const ITMVoxelBlockHash::IndexData *voxelIndex,
 		Vector3i blockPos,
 		int *locks,
 		int *voxelAllocationList,
 		int *lastFreeBlockId,
 		uchar *entriesVisibleType
 ) {
-	int keyHash = hashIndex(blockPos);
+	ITMHashEntry *hashTable = voxelIndex->entries;
+	int keyHash = hashIndex(blockPos, voxelIndex->hashMask);
 
 	// Lock the bucket for the operation, to ensure the lists stay consistent
 	int status = atomicExch(&locks[keyHash], BUCKET_LOCKED);
@@ -1032,9 +1052,9 @@ void deleteBlock(
 	bool isFound = false;
 	int outBlockIdx = -1;
 	int outPrevBlockIdx = -1;
-	findVoxel(hashTable, blockPos, 0, isFound, outBlockIdx, outPrevBlockIdx);
+	findVoxel(voxelIndex, blockPos, 0, isFound, outBlockIdx, outPrevBlockIdx);
 
-	bool isExcess = (outBlockIdx >= SDF_BUCKET_NUM);
+	bool isExcess = (outBlockIdx >= voxelIndex->bucketNum);
 
 	// Paranoid sanity checks
 	if (paranoid) {
@@ -1081,7 +1101,7 @@ void deleteBlock(
 		// In the ordered list
 		if (hashTable[outBlockIdx].offset >= 1) {
 			// In the ordered list, with a successor.
-			long nextIdx = SDF_BUCKET_NUM + hashTable[outBlockIdx].offset - 1;
+			long nextIdx = voxelIndex->bucketNum + hashTable[outBlockIdx].offset - 1;
 			hashTable[outBlockIdx] = hashTable[nextIdx];
 
 			entriesVisibleType[outBlockIdx] = entriesVisibleType[nextIdx];
@@ -1123,7 +1143,7 @@ void decayVoxel(
 		Vector3i blockPos,
 		int locId,
 		TVoxel *localVBA,				// could wrap in HashMap struct
-		ITMHashEntry *hashTable,		// could wrap
+		const ITMVoxelBlockHash::IndexData *voxelIndex,
 		int minAge,
 		int maxWeight,
 		int *voxelAllocationList,		// could wrap
@@ -1136,12 +1156,13 @@ void decayVoxel(
 	int blockHashIdx = -1;
 	int blockPrevHashIdx = -1;
 
-	int voxelIdx = findVoxel(hashTable, blockPos, locId, isFound, blockHashIdx, blockPrevHashIdx);
+	const ITMHashEntry *hashTable = voxelIndex->entries;
+	int voxelIdx = findVoxel(voxelIndex, blockPos, locId, isFound, blockHashIdx, blockPrevHashIdx);
 
 	if (-1 == blockHashIdx) {
 		if (locId == 0) {
 			printf("ERROR: could not find bucket for (%d, %d, %d) @ hash ID %d.\n",
-				   blockPos.x, blockPos.y, blockPos.z, hashIndex(blockPos));
+				   blockPos.x, blockPos.y, blockPos.z, hashIndex(blockPos, voxelIndex->hashMask));
 		}
 		return;
 	}
@@ -1187,7 +1208,7 @@ void decayVoxel(
 	bool emptyBlock = (emptyVoxels == voxelsPerBlock);
 
 	if (locId == 0 && emptyBlock && safeToClear) {
-		deleteBlock<TVoxel>(hashTable,
+		deleteBlock<TVoxel>(voxelIndex,
 							blockPos,
 							locks,
 							voxelAllocationList,
@@ -1201,7 +1222,7 @@ void decayVoxel(
 template<class TVoxel>
 __global__
 void decay_device(TVoxel *localVBA,
-				  ITMHashEntry *hashTable,
+				  const ITMVoxelBlockHash::IndexData *voxelIndex,
 				  Vector3i *visibleBlockPositions,
 				  int minAge,
 				  int maxWeight,
@@ -1216,17 +1237,17 @@ void decay_device(TVoxel *localVBA,
 	int locId = threadIdx.x + threadIdx.y * SDF_BLOCK_SIZE + threadIdx.z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
 
 	bool isFound = false;
-	int hashIdx = findBlock(hashTable, visibleBlockPositions[blockIdx.x], isFound);
+	int hashIdx = findBlock(voxelIndex, visibleBlockPositions[blockIdx.x], isFound);
 
 	if (!isFound || hashIdx < 0) {
 		// The block was already de-allocated.
 		return;
 	}
 
-	const ITMHashEntry &currentHashEntry = hashTable[hashIdx];
+	const ITMHashEntry &currentHashEntry = voxelIndex->entries[hashIdx];
 
 	Vector3i blockGridPos = currentHashEntry.pos.toInt();
-	decayVoxel<TVoxel>(blockGridPos, locId, localVBA, hashTable, minAge, maxWeight,
+	decayVoxel<TVoxel>(blockGridPos, locId, localVBA, voxelIndex, minAge, maxWeight,
 					   voxelAllocationList, lastFreeBlockId, locks, currentFrame, entriesVisibleType);
 }
 
@@ -1236,7 +1257,7 @@ __global__
 void decayFull_device(
 		const Vector4s *usedBlockPositions,
 		TVoxel *localVBA,
-		ITMHashEntry *hashTable,
+		const ITMVoxelBlockHash::IndexData *voxelIndex,
 		int minAge,
 		int maxWeight,
 		int *voxelAllocationList,
@@ -1257,7 +1278,7 @@ void decayFull_device(
 	const Vector3i blockPos = Vector3i(blockGridPos_4s.x, blockGridPos_4s.y, blockGridPos_4s.z);
 	int locId = threadIdx.x + threadIdx.y * blockDim.x + threadIdx.z * blockDim.y * blockDim.x;
 
-	decayVoxel<TVoxel>(blockPos, locId, localVBA, hashTable, minAge, maxWeight, voxelAllocationList,
+	decayVoxel<TVoxel>(blockPos, locId, localVBA, voxelIndex, minAge, maxWeight, voxelAllocationList,
 					 lastFreeBlockId, locks, currentFrame, entriesVisibleType);
 }
 
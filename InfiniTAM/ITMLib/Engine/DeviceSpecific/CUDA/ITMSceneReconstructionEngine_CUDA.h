@@ -11,14 +11,6 @@ namespace ITMLib
 {
 	namespace Engine
 	{
-		/// \brief A snapshot of what blocks were visible at some point in time. Needed by the voxel
-		///        decay.
-		struct VisibleBlockInfo {
-			size_t count;
-			size_t frameIdx;
-			ORUtils::MemoryBlock<Vector3i> *blockCoords;
-		};
-
 		template<class TVoxel, class TIndex>
 		class ITMSceneReconstructionEngine_CUDA : public ITMSceneReconstructionEngine < TVoxel, TIndex >
 		{};
@@ -28,6 +20,10 @@ namespace ITMLib
 		class ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash> : public ITMSceneReconstructionEngine < TVoxel, ITMVoxelBlockHash >
 		{
 		private:
+			// Sizes of the hash tables this engine can work with; see ITMLibSettings.
+			int sdfBucketNum;
+			int sdfExcessListSize;
+
 			void *allocationTempData_device;
 			void *allocationTempData_host;
 			unsigned char *entriesAllocType_device;
@@ -78,7 +74,9 @@ namespace ITMLib
 
 			size_t GetDecayedBlockCount() override;
 
-			ITMSceneReconstructionEngine_CUDA(long sdfLocalBlockNum);
+			ITMSceneReconstructionEngine_CUDA(long sdfLocalBlockNum,
+											  long sdfBucketNum = DEFAULT_SDF_BUCKET_NUM,
+											  long sdfExcessListSize = DEFAULT_SDF_EXCESS_LIST_SIZE);
 			~ITMSceneReconstructionEngine_CUDA(void);
 		};
 
@@ -22,7 +22,7 @@ inline dim3 getGridSize(Vector2i taskSize, dim3 blockSize) { return getGridSize(
 __global__ void buildVisibleList_device(const ITMHashEntry *hashTable, /*ITMHashCacheState *cacheStates, bool useSwapping,*/ int noTotalEntries,
 	Vector3i *visibleBlocks, int *noVisibleBlocks, uchar *entriesVisibleType, Matrix4f M, Vector4f projParams, Vector2i imgSize, float voxelSize);
 
-__global__ void projectAndSplitBlocks_device(const ITMHashEntry *hashEntries, const Vector3i *visibleBlocks, int noVisibleBlocks,
+__global__ void projectAndSplitBlocks_device(const ITMVoxelBlockHash::IndexData *voxelIndex, const Vector3i *visibleBlocks, int noVisibleBlocks,
 	const Matrix4f pose_M, const Vector4f intrinsics, const Vector2i imgSize, float voxelSize, RenderingBlock *renderingBlocks,
 	uint *noTotalBlocks);
 
@@ -139,7 +139,7 @@ template<class TVoxel>
 ITMRenderState_VH* ITMVisualisationEngine_CUDA<TVoxel, ITMVoxelBlockHash>::CreateRenderState(const Vector2i & imgSize) const
 {
 	return new ITMRenderState_VH(
-		ITMVoxelBlockHash::noTotalEntries, imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, this->settings->sdfLocalBlockNum, MEMORYDEVICE_CUDA
+		this->scene->index.noTotalEntries, imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, this->settings->sdfLocalBlockNum, MEMORYDEVICE_CUDA
 	);
 }
 
@@ -207,7 +207,7 @@ void ITMVisualisationEngine_CUDA<TVoxel, ITMVoxelBlockHash>::CreateExpectedDepth
 
 	// go through list of visible 8x8x8 blocks, unless none are visible
 	{
-		const ITMHashEntry *hash_entries = this->scene->index.GetEntries();
+		const ITMVoxelBlockHash::IndexData *voxelIndex = this->scene->index.getIndexData();
 		const Vector3i *visbleBlocks = renderState_vh->GetVisibleBlockPositions();
 		int noVisibleBlocks = renderState_vh->noVisibleBlocks;
 
@@ -217,7 +217,7 @@ void ITMVisualisationEngine_CUDA<TVoxel, ITMVoxelBlockHash>::CreateExpectedDepth
 			ITMSafeCall(cudaMemset(noTotalBlocks_device, 0, sizeof(uint)));
 
 			projectAndSplitBlocks_device << < gridSize, blockSize >> > (
-				hash_entries, visbleBlocks, noVisibleBlocks, pose->GetM(),
+				voxelIndex, visbleBlocks, noVisibleBlocks, pose->GetM(),
 				intrinsics->projectionParamsSimple.all, imgSize, voxelSize,
 				renderingBlockList_device, noTotalBlocks_device);
 		}
@@ -569,7 +569,7 @@ __global__ void buildVisibleList_device(const ITMHashEntry *hashTable, /*ITMHash
 }
 
 // Runs over the visible list => need to look keys up
-__global__ void projectAndSplitBlocks_device(const ITMHashEntry *hashEntries, const Vector3i* visibleBlocks, int noVisibleBlocks,
+__global__ void projectAndSplitBlocks_device(const ITMVoxelBlockHash::IndexData *voxelIndex, const Vector3i* visibleBlocks, int noVisibleBlocks,
 	const Matrix4f pose_M, const Vector4f intrinsics, const Vector2i imgSize, float voxelSize, RenderingBlock *renderingBlocks,
 	uint *noTotalBlocks)
 {
@@ -579,7 +579,7 @@ __global__ void projectAndSplitBlocks_device(const ITMHashEntry *hashEntries, co
 	// flickering in the visualization.
 
 	bool isFound = false;
-	int hashIdx = findBlock(hashEntries, visibleBlocks[in_offset], isFound);
+	int hashIdx = findBlock(voxelIndex, visibleBlocks[in_offset], isFound);
 
   // TODO(andrei): Clean up this code; it seems to also have to run when the block is not found/valid.
   // But make sure you don't segfault.
@@ -589,7 +589,7 @@ __global__ void projectAndSplitBlocks_device(const ITMHashEntry *hashEntries, co
 	bool validProjection = false;
 	if (in_offset < noVisibleBlocks) {
 		if (isFound) {
-			const ITMHashEntry & blockData(hashEntries[hashIdx]);
+			const ITMHashEntry & blockData(voxelIndex->entries[hashIdx]);
 			if(blockData.ptr >= 0) {
 				validProjection = ProjectSingleBlock(blockData.pos, pose_M, intrinsics, imgSize, voxelSize, upperLeft, lowerRight, zRange);
 			}
@@ -224,9 +224,9 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
                     
                     hashTable[targetIdx].offset = exlOffset + 1; //connect to child
                     
-                    hashTable[SDF_BUCKET_NUM + exlOffset] = hashEntry; //add child to the excess list
+                    hashTable[scene->index.getBucketNum() + exlOffset] = hashEntry; //add child to the excess list
                     
-                    entriesVisibleType[SDF_BUCKET_NUM + exlOffset] = 1; //make child visible and in memory
+                    entriesVisibleType[scene->index.getBucketNum() + exlOffset] = 1; //make child visible and in memory
                 }
                 
                 break;
@@ -16,12 +16,14 @@ ITMDenseMapper<TVoxel, TIndex>::ITMDenseMapper(const ITMLibSettings *settings)
 	switch (settings->deviceType)
 	{
 	case ITMLibSettings::DEVICE_CPU:
-		sceneRecoEngine = new ITMSceneReconstructionEngine_CPU<TVoxel,TIndex>();
+		sceneRecoEngine = new ITMSceneReconstructionEngine_CPU<TVoxel,TIndex>(
+				settings->sdfBucketNum, settings->sdfExcessListSize);
 		if (settings->useSwapping) swappingEngine = new ITMSwappingEngine_CPU<TVoxel,TIndex>();
 		break;
 	case ITMLibSettings::DEVICE_CUDA:
 #ifndef COMPILE_WITHOUT_CUDA
-		sceneRecoEngine = new ITMSceneReconstructionEngine_CUDA<TVoxel,TIndex>(settings->sdfLocalBlockNum);
+		sceneRecoEngine = new ITMSceneReconstructionEngine_CUDA<TVoxel,TIndex>(
+				settings->sdfLocalBlockNum, settings->sdfBucketNum, settings->sdfExcessListSize);
 		if (settings->useSwapping) {
 			swappingEngine = new ITMSwappingEngine_CUDA<TVoxel,TIndex>(settings->sdfLocalBlockNum);
 		}
@@ -34,6 +36,12 @@ ITMDenseMapper<TVoxel, TIndex>::ITMDenseMapper(const ITMLibSettings *settings)
 #endif
 		break;
 	}
+
+	HashGrowthParams hashGrowthParams;
+	hashGrowthParams.enabled = settings->growHashTable && !settings->useSwapping;
+	hashGrowthParams.bucketsMigratedPerFrame = settings->hashGrowthBucketsPerFrame;
+	sceneRecoEngine->SetHashGrowthParams(hashGrowthParams);
+	sceneRecoEngine->SetOccupancyGrid(settings->useOccupancyGrid);
 }
 
 template<class TVoxel, class TIndex>
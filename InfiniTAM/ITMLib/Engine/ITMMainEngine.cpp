@@ -18,7 +18,9 @@ ITMMainEngine::ITMMainEngine(const ITMLibSettings *settings, const ITMRGBDCalib
 			&(settings->sceneParams),
 			settings->useSwapping,
 			settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU,
-			settings->sdfLocalBlockNum);
+			settings->sdfLocalBlockNum,
+			settings->sdfBucketNum,
+			settings->sdfExcessListSize);
 
 	meshingEngine = NULL;
 	switch (settings->deviceType)
@@ -53,12 +55,15 @@ ITMMainEngine::ITMMainEngine(const ITMLibSettings *settings, const ITMRGBDCalib
 		break;
 	}
 
+	if (meshingEngine != NULL) meshingEngine->SetIncrementalMeshing(settings->useIncrementalMeshing);
+
 	mesh = NULL;
 	if (createMeshingEngine) {
 		MemoryDeviceType deviceType = (settings->deviceType == ITMLibSettings::DEVICE_CUDA
 		                               ? MEMORYDEVICE_CUDA
 		                               : MEMORYDEVICE_CPU);
-		mesh = new ITMMesh(deviceType, settings->sdfLocalBlockNum);
+		bool isIndexed = settings->createIndexedMesh && deviceType == MEMORYDEVICE_CPU;
+		mesh = new ITMMesh(deviceType, settings->sdfLocalBlockNum, isIndexed);
 	}
 
 	Vector2i trackedImageSize = ITMTrackingController::GetTrackedImageSize(settings, imgSize_rgb, imgSize_d);
@@ -128,8 +133,34 @@ void ITMMainEngine::SaveSceneToMesh(const char *objFileName)
 	if (!write_result.valid() ||
 		 write_result.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready
 	) {
-		// TODO(andrei): This seems to be memory-intensive. One could maybe also do this in a
-		// streaming manner, instead of running marching cubes on everything at once.
+		bool isPLY = fname.size() >= 4 && fname.compare(fname.size() - 4, 4, ".ply") == 0;
+
+		// On the CPU, the hashed scenes are meshed and written chunk by chunk, so that saving a
+		// large map does not need a mesh of the whole scene in memory. This runs on the calling
+		// thread, as the scene must not change while it is read.
+		if (settings->deviceType == ITMLibSettings::DEVICE_CPU && ITM_VOXEL_INDEX != ITM_VOXEL_INDEX_PLAIN) {
+			if (isPLY) {
+				ITMMeshPLYFileSink sink(fname.c_str());
+				meshingEngine->MeshSceneStreamed(&sink, scene, settings->createIndexedMesh);
+				sink.Close();
+				printf(" >>> Streamed %u triangles to %s.\n", sink.GetNoWrittenTriangles(), fname.c_str());
+			}
+			else {
+				ITMMeshOBJFileSink sink(fname.c_str());
+				meshingEngine->MeshSceneStreamed(&sink, scene, settings->createIndexedMesh);
+				printf(" >>> Streamed %u triangles to %s.\n", sink.GetNoWrittenTriangles(), fname.c_str());
+			}
+			return;
+		}
+
+		// Binary PLY files are written in seconds, even for large meshes.
+		if (isPLY) {
+			meshingEngine->MeshScene(mesh, scene);
+			mesh->WritePLY(fname.c_str());
+			printf(" >>> Wrote %u triangles to %s.\n", mesh->noTotalTriangles, fname.c_str());
+			return;
+		}
+
 		meshingEngine->MeshScene(mesh, scene);
 
 		// Mesh generation is fast (less than a second), but writing stuff to the disk can take
@@ -251,13 +282,29 @@ void ITMMainEngine::GetImage(ITMUChar4Image *out, ITMFloatImage *outFloat, GetIm
 			renderState_freeview = visualisationEngine->CreateRenderState(noDims);
 		}
 
+		// On the CPU, depth maps are rendered straight into the caller's image.
+		ITMFloatImage *floatImage = renderState_freeview->raycastFloatImage;
+		if (settings->deviceType != ITMLibSettings::DEVICE_CUDA &&
+			getImageType == ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_DEPTH) {
+			outFloat->ChangeDims(noDims);
+			floatImage = outFloat;
+		}
+
 		// This renders the free camera view. It uses raycasting.
-		visualisationEngine->FindVisibleBlocks(pose, intrinsics, renderState_freeview);
-		visualisationEngine->CreateExpectedDepths(pose, intrinsics, renderState_freeview);
-		visualisationEngine->RenderImage(pose, intrinsics, renderState_freeview,
-										 renderState_freeview->raycastImage,
-										 renderState_freeview->raycastFloatImage,
-										 type);
+		if (settings->useIncrementalFreeviewRendering) {
+			visualisationEngine->RenderImageIncremental(pose, intrinsics, renderState_freeview,
+														renderState_freeview->raycastImage,
+														floatImage,
+														type);
+		}
+		else {
+			visualisationEngine->FindVisibleBlocks(pose, intrinsics, renderState_freeview);
+			visualisationEngine->CreateExpectedDepths(pose, intrinsics, renderState_freeview);
+			visualisationEngine->RenderImage(pose, intrinsics, renderState_freeview,
+											 renderState_freeview->raycastImage,
+											 floatImage,
+											 type);
+		}
 
 		if (settings->deviceType == ITMLibSettings::DEVICE_CUDA) {
 			// Depth is rendered as float, the rest, as RGBA uchars.
@@ -270,8 +317,7 @@ void ITMMainEngine::GetImage(ITMUChar4Image *out, ITMFloatImage *outFloat, GetIm
 							 ORUtils::MemoryBlock<Vector4u>::CUDA_TO_CPU);
 			}
 		}
-		else {
-			// depth rendering is unsupported in CPU mode
+		else if (getImageType != ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_DEPTH) {
 			out->SetFrom(renderState_freeview->raycastImage, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
 		}
 		break;
@@ -84,8 +84,8 @@ namespace ITMLib
 				InfiniTAM_IMAGE_FREECAMERA_SHADED,
 				InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_VOLUME,
 				InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_NORMAL,
-				InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_DEPTH_WEIGHT,		// CUDA-only
-			  	InfiniTAM_IMAGE_FREECAMERA_DEPTH,							// CUDA-only
+				InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_DEPTH_WEIGHT,
+			  	InfiniTAM_IMAGE_FREECAMERA_DEPTH,							// float, in metres
 				InfiniTAM_IMAGE_UNKNOWN
 			};
 
@@ -107,7 +107,11 @@ namespace ITMLib
 			/// Update the internally stored mesh data structure and return a pointer to it
 			ITMMesh* UpdateMesh(void);
 
-			/// Extracts a mesh from the current scene and saves it to the obj file specified by the file name
+			/// Extracts a mesh from the current scene and saves it to the file specified by the file name,
+			/// as binary PLY if the name ends with ".ply", and as OBJ otherwise. Hashed scenes on the CPU
+			/// are meshed and written in chunks, without building the whole mesh; this blocks until the
+			/// file is written. Otherwise, OBJ files are written in the background, as formatting them
+			/// takes much longer than meshing.
 			void SaveSceneToMesh(const char *objFileName);
 
 			/// Get a result image as output
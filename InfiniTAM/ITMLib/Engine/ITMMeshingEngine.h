@@ -3,6 +3,7 @@
 #pragma once
 
 #include <math.h>
+#include <stdexcept>
 
 #include "../Utils/ITMLibDefines.h"
 
@@ -21,6 +22,25 @@ namespace ITMLib
 		public:
 			virtual void MeshScene(ITMMesh *mesh, const ITMScene<TVoxel,TIndex> *scene) = 0;
 
+			/// \brief Meshes the scene in spatial chunks of chunkSize^3 voxel blocks, and hands the
+			///        mesh of every chunk which has any triangles to the sink before moving on to the
+			///        next one. Only one chunk is held in memory, however big the scene. The chunks are
+			///        indexed meshes if isIndexed is set, but do not share the vertices on their borders.
+			virtual void MeshSceneStreamed(ITMMeshSink *sink, const ITMScene<TVoxel,TIndex> *scene, bool isIndexed,
+				int chunkSize = 16)
+			{
+				throw std::runtime_error("Streamed meshing is not supported by this meshing engine.");
+			}
+
+			/// \brief Switches between meshing only what changed since the last call to MeshScene,
+			///        and meshing the entire scene every time (default). Engines which only support
+			///        the latter throw when asked for the former.
+			virtual void SetIncrementalMeshing(bool useIncrementalMeshing)
+			{
+				if (useIncrementalMeshing)
+					throw std::runtime_error("Incremental meshing is not supported by this meshing engine.");
+			}
+
 			ITMMeshingEngine(void) { }
 			virtual ~ITMMeshingEngine(void) { }
 		};
@@ -10,6 +10,7 @@
 #include "../Objects/ITMView.h"
 #include "../Objects/ITMTrackingState.h"
 #include "../Objects/ITMRenderState.h"
+#include "../../ORUtils/MemoryBlock.h"
 
 using namespace ITMLib::Objects;
 
@@ -17,11 +18,32 @@ namespace ITMLib
 {
 	namespace Engine
 	{
+		/// \brief A snapshot of what blocks were visible at some point in time. Needed by the voxel
+		///        decay.
+		struct VisibleBlockInfo {
+			size_t count;
+			size_t frameIdx;
+			ORUtils::MemoryBlock<Vector3i> *blockCoords;
+		};
+
 		// Used to configure the measurement fusion weighting.
 		struct WeightParams {
 			bool depthWeighting = false;
 		};
 
+		// Used to configure the online growth of voxel block hash tables, which is currently only
+		// supported by the CPU engine. See ITMVoxelBlockHash::BeginGrowth.
+		struct HashGrowthParams {
+			bool enabled = false;
+			// The table grows once this fraction of the excess list is in use...
+			float maxExcessListUsage = 0.75f;
+			// ...or once there are more allocated blocks than this fraction of the bucket count.
+			float maxLoadFactor = 0.75f;
+			// Number of buckets of the previous table migrated per frame while the table grows.
+			// Bounds the extra work done in any single frame.
+			int bucketsMigratedPerFrame = 0x8000;
+		};
+
 		/** \brief
 		    Interface to engines implementing the main KinectFusion
 		    depth integration process.
@@ -35,6 +57,8 @@ namespace ITMLib
 		{
 		private:
 			WeightParams fusionWeightParams;
+			HashGrowthParams hashGrowthParams;
+			bool occupancyGrid = false;
 
 		public:
 			/** Clear and reset a scene to set up a new empty
@@ -73,6 +97,25 @@ namespace ITMLib
 				return fusionWeightParams;
 			}
 
+			virtual void SetHashGrowthParams(const HashGrowthParams &hashGrowthParams) {
+				this->hashGrowthParams = hashGrowthParams;
+			}
+
+			HashGrowthParams GetHashGrowthParams() {
+				return hashGrowthParams;
+			}
+
+			/** Whether ResetScene gives the hash table of the scene an occupancy grid, which the
+			    raycaster uses to skip empty space; see ITMVoxelBlockHash::SetOccupancyGrid. Only
+			    supported by the CPU engine with the chained hash table. */
+			virtual void SetOccupancyGrid(bool occupancyGrid) {
+				this->occupancyGrid = occupancyGrid;
+			}
+
+			bool GetOccupancyGrid() {
+				return occupancyGrid;
+			}
+
 			ITMSceneReconstructionEngine(void) { }
 			virtual ~ITMSceneReconstructionEngine(void) { }
 		};
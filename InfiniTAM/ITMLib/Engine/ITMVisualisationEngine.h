@@ -24,10 +24,8 @@ namespace ITMLib
 				RENDER_SHADED_GREYSCALE,
 				RENDER_COLOUR_FROM_VOLUME,
 				RENDER_COLOUR_FROM_NORMAL,
-			  	// Note: not supported on the CPU (TODO(andrei): Support this on the CPU based on
-				// the CUDA code. It should be very straightforward.)
 				RENDER_COLOUR_FROM_DEPTH_WEIGHT,
-				// Note: not supported on the CPU.
+				// Rendered into the float output image, in metres.
 				RENDER_DEPTH_MAP
 			};
 
@@ -61,6 +59,24 @@ namespace ITMLib
 									 ITMFloatImage *outputFloatImage,
 									 RenderImageType type = RENDER_SHADED_GREYSCALE) const = 0;
 
+			/** Renders a free-viewpoint image like FindVisibleBlocks,
+			CreateExpectedDepths and RenderImage do together, but may
+			reuse the raycast of the previous call with the same
+			render state: its points are forward projected into the
+			new view, and only the pixels they leave uncovered are
+			raycast. See ITMLibSettings::useIncrementalFreeviewRendering.
+
+			The default implementation always renders from scratch.
+			*/
+			virtual void RenderImageIncremental(const ITMPose *pose, const ITMIntrinsics *intrinsics,
+				ITMRenderState *renderState, ITMUChar4Image *outputCharImage, ITMFloatImage *outputFloatImage,
+				RenderImageType type = RENDER_SHADED_GREYSCALE) const
+			{
+				FindVisibleBlocks(pose, intrinsics, renderState);
+				CreateExpectedDepths(pose, intrinsics, renderState);
+				RenderImage(pose, intrinsics, renderState, outputCharImage, outputFloatImage, type);
+			}
+
 			/** Finds the scene surface using raycasting. */
 			virtual void FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics,
 				const ITMRenderState *renderState) const = 0;
@@ -96,6 +112,7 @@ namespace ITMLib
 
 		template<class TIndex> struct IndexToRenderState { typedef ITMRenderState type; };
 		template<> struct IndexToRenderState<ITMVoxelBlockHash> { typedef ITMRenderState_VH type; };
+		template<> struct IndexToRenderState<ITMVoxelBlockOpenHash> { typedef ITMRenderState_VH type; };
 
 		/** \brief
 			Interface to engines helping with the visualisation of
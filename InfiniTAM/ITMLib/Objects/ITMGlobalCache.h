@@ -43,7 +43,7 @@ namespace ITMLib
 
 			int noTotalEntries; 
 
-			ITMGlobalCache() : noTotalEntries(SDF_BUCKET_NUM + SDF_EXCESS_LIST_SIZE)
+			explicit ITMGlobalCache(int noTotalEntries) : noTotalEntries(noTotalEntries)
 			{	
 				hasStoredData = (bool*)malloc(noTotalEntries * sizeof(bool));
 				storedVoxelBlocks = (TVoxel*)malloc(noTotalEntries * sizeof(TVoxel) * SDF_BLOCK_SIZE3);
@@ -14,21 +14,58 @@ namespace ITMLib
 		/** \brief
 		Stores the actual voxel content that is referred to by a
 		ITMLib::Objects::ITMHashTable.
+
+		In CPU memory, the VBA also counts the changes to every block: whoever changes the voxels
+		calls VoxelsChanged on the changed range. Whoever keeps something derived from the blocks,
+		e.g., the incremental mesher, can compare the counts to the ones it last saw to find the
+		blocks which are dirty.
 		*/
 		template<class TVoxel>
 		class ITMLocalVBA
 		{
 		private:
 			ORUtils::MemoryBlock<TVoxel> *voxelBlocks;
+			ORUtils::MemoryBlock<unsigned int> *blockVersions;
 			ORUtils::MemoryBlock<int> *allocationList;
 
 			MemoryDeviceType memoryType;
+			int blockSize;
+			unsigned int version;
 
 		public:
 			inline TVoxel *GetVoxelBlocks(void) { return voxelBlocks->GetData(memoryType); }
 			inline const TVoxel *GetVoxelBlocks(void) const { return voxelBlocks->GetData(memoryType); }
 			int *GetAllocationList(void) { return allocationList->GetData(memoryType); }
 
+			/// \brief The number of changes to every block, or NULL if the VBA does not count them.
+			///        Wraps around.
+			inline const unsigned int *GetBlockVersions(void) const {
+				return blockVersions != NULL ? blockVersions->GetData(memoryType) : NULL;
+			}
+
+			/// \brief The number of calls to VoxelsChanged so far, which changes whenever any voxel
+			///        does. Wraps around.
+			inline unsigned int GetVersion(void) const { return version; }
+
+			/// \brief Has to be called after changing the voxels [offset, offset + noVoxels). Counts a
+			///        change of the blocks they are in, and of the VBA. Calls for ranges in different
+			///        blocks can run in parallel.
+			void VoxelsChanged(int offset, int noVoxels)
+			{
+				if (noVoxels <= 0) return;
+
+#ifdef WITH_OPENMP
+				#pragma omp atomic
+#endif
+				version++;
+
+				if (blockVersions != NULL)
+				{
+					unsigned int *versions = blockVersions->GetData(memoryType);
+					for (int blockId = offset / blockSize; blockId <= (offset + noVoxels - 1) / blockSize; blockId++) versions[blockId]++;
+				}
+			}
+
 #ifdef COMPILE_WITH_METAL
 			const void* GetVoxelBlocks_MB() const { return voxelBlocks->GetMetalBuffer(); }
 			const void* GetAllocationList_MB(void) const { return allocationList->GetMetalBuffer(); }
@@ -40,6 +77,8 @@ namespace ITMLib
 			ITMLocalVBA(MemoryDeviceType memoryType, int noBlocks, int blockSize)
 			{
 				this->memoryType = memoryType;
+				this->blockSize = blockSize;
+				version = 0;
 
 				allocatedSize = noBlocks * blockSize;
 
@@ -47,11 +86,15 @@ namespace ITMLib
 					noBlocks, blockSize);
 				voxelBlocks = new ORUtils::MemoryBlock<TVoxel>(allocatedSize, memoryType);
 				allocationList = new ORUtils::MemoryBlock<int>(noBlocks, memoryType);
+
+				blockVersions = NULL;
+				if (memoryType == MEMORYDEVICE_CPU) blockVersions = new ORUtils::MemoryBlock<unsigned int>(noBlocks, memoryType);
 			}
 
 			~ITMLocalVBA(void)
 			{
 				delete voxelBlocks;
+				delete blockVersions;
 				delete allocationList;
 			}
 
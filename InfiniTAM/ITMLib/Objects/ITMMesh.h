@@ -5,9 +5,12 @@
 #include "../Utils/ITMLibDefines.h"
 #include "../../ORUtils/Image.h"
 
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include <stdlib.h>
+#include <vector>
 
 namespace ITMLib
 {
@@ -21,30 +24,128 @@ namespace ITMLib
 				Vector3f p0, p1, p2;
               	Vector3f c0, c1, c2;
 			};
+
+			/// \brief A vertex of an indexed mesh, with its color.
+			struct Vertex {
+				Vector3f p, c;
+			};
 		
 			MemoryDeviceType memoryType;
 
+			/// \brief Whether the mesh is stored as a vertex buffer plus three vertex indices per
+			///        triangle, instead of as separate triangles. Indexed meshes only live on the CPU.
+			const bool isIndexed;
+
 			uint noTotalTriangles;
-			const uint noMaxTriangles;
+			/// Capacity of the triangle buffer, or of the index buffer of an indexed mesh (in
+			/// triangles). Meshing engines which can tell how many triangles they produce grow it
+			/// with Reserve instead of dropping triangles.
+			uint noMaxTriangles;
+
+			uint noTotalVertices;
+			uint noMaxVertices;
 
 			ORUtils::MemoryBlock<Triangle> *triangles;
+			/// The buffers of an indexed mesh. Triangle i has the vertices indices[3 * i + k].
+			ORUtils::MemoryBlock<Vertex> *vertices;
+			ORUtils::MemoryBlock<uint> *indices;
 
-			explicit ITMMesh(MemoryDeviceType memoryType, long sdfLocalBlockNum)
+			/// Indexed meshes are allocated on demand, by Reserve, as the number of triangles of a
+			/// mesh is known before it is written out.
+			explicit ITMMesh(MemoryDeviceType memoryType, long sdfLocalBlockNum, bool isIndexed = false)
 				: memoryType(memoryType),
+				  isIndexed(isIndexed),
 				  noTotalTriangles(0),
-				  noMaxTriangles(sdfLocalBlockNum * SDF_BLOCK_SIZE3 / 16)
+				  noMaxTriangles(isIndexed ? 0 : sdfLocalBlockNum * SDF_BLOCK_SIZE3 / 16),
+				  noTotalVertices(0),
+				  noMaxVertices(0)
 			{
-				printf("Allocating memory block for mesh triangles. noMaxTriangles=%d.\n", noMaxTriangles);
-				triangles = new ORUtils::MemoryBlock<Triangle>(noMaxTriangles, memoryType);
+				if (isIndexed && memoryType != MEMORYDEVICE_CPU) {
+					throw std::runtime_error("Indexed meshes are only supported in CPU memory.");
+				}
+
+				if (!isIndexed) {
+					printf("Allocating memory block for mesh triangles. noMaxTriangles=%d.\n", noMaxTriangles);
+				}
+				triangles = new ORUtils::MemoryBlock<Triangle>(isIndexed ? 0 : noMaxTriangles, memoryType);
+				vertices = new ORUtils::MemoryBlock<Vertex>(0, memoryType);
+				indices = new ORUtils::MemoryBlock<uint>(0, memoryType);
+			}
+
+			/// \brief Makes room for at least noTriangles triangles, and, for an indexed mesh,
+			///        noVertices vertices. If a buffer has to grow, the mesh is lost, so this must be
+			///        called before meshing.
+			void Reserve(uint noTriangles, uint noVertices = 0)
+			{
+				if (noTriangles > noMaxTriangles) {
+					noMaxTriangles = GrownCapacity(noMaxTriangles, noTriangles);
+					noTotalTriangles = noTotalVertices = 0;
+
+					if (isIndexed) {
+						delete indices;
+						indices = new ORUtils::MemoryBlock<uint>(noMaxTriangles * 3, memoryType);
+					}
+					else {
+						delete triangles;
+						triangles = new ORUtils::MemoryBlock<Triangle>(noMaxTriangles, memoryType);
+					}
+				}
+
+				if (isIndexed && noVertices > noMaxVertices) {
+					noMaxVertices = GrownCapacity(noMaxVertices, noVertices);
+					noTotalTriangles = noTotalVertices = 0;
+
+					delete vertices;
+					vertices = new ORUtils::MemoryBlock<Vertex>(noMaxVertices, memoryType);
+				}
 			}
 
 			/// \brief Writes the mesh as a Wavefront OBJ file with color support.
 			/// \note The Wavefront OBJ format does not officially support voxel color information,
 			///       so some viewers (e.g., Blender) may not display it. Other viewers, such as
-			///       MeshLab can display per-voxel colors for OBJ files.
-			/// TODO(andrei): Use the `ply` format, which does support color information officially.
+			///       MeshLab can display per-voxel colors for OBJ files. WritePLY writes colors which
+			///       all viewers understand, and is much faster.
 			void WriteOBJ(const char *fileName)
 			{
+				if (noTotalTriangles > noMaxTriangles) {
+					std::stringstream ss;
+					ss << "Unable to save mesh to file [" << fileName << "]. Too many triangles: "
+					   << noTotalTriangles << " while the maximum is " << noMaxTriangles << ".";
+					throw std::runtime_error(ss.str());
+				}
+
+				FILE *f = fopen(fileName, "w+");
+				if (f == NULL) throw std::runtime_error("Could not open file for writing the mesh.\n");
+
+				printf("Starting to write mesh...\n");
+				AppendOBJ(f, 0);
+				fclose(f);
+
+				printf("Mesh file writing to [%s] complete.\n", fileName);
+			}
+
+			/// \brief Appends the mesh to an OBJ file which already has vertexOffset vertices, so
+			///        that a mesh can be written piece by piece. Indexed meshes write every vertex
+			///        once. Returns the number of vertices written.
+			uint AppendOBJ(FILE *f, uint vertexOffset) const
+			{
+				if (isIndexed) {
+					const Vertex *vertexArray = vertices->GetData(MEMORYDEVICE_CPU);
+					const uint *indexArray = indices->GetData(MEMORYDEVICE_CPU);
+
+					for (uint i = 0; i < noTotalVertices; i++) {
+						const Vertex &v = vertexArray[i];
+						fprintf(f, "v %f %f %f %f %f %f\n", v.p.x, v.p.y, v.p.z, v.c.r, v.c.g, v.c.b);
+					}
+
+					// Same winding as the triangle soup.
+					for (uint i = 0; i < noTotalTriangles; i++) {
+						fprintf(f, "f %u %u %u\n", vertexOffset + indexArray[i * 3 + 2] + 1,
+								vertexOffset + indexArray[i * 3 + 1] + 1, vertexOffset + indexArray[i * 3 + 0] + 1);
+					}
+					return noTotalVertices;
+				}
+
 				ORUtils::MemoryBlock<Triangle> *cpu_triangles;
 				bool shouldDelete = false;
 				if (memoryType == MEMORYDEVICE_CUDA)
@@ -59,6 +160,53 @@ namespace ITMLib
 
 				Triangle *triangleArray = cpu_triangles->GetData(MEMORYDEVICE_CPU);
 
+				for (uint i = 0; i < noTotalTriangles; i++) {
+					if ((i + 1) % 100000 == 0) {
+						printf("Triangle %d/%d\n", i + 1, noTotalTriangles);
+					}
+					const Vector3f &c0 = triangleArray[i].c0;
+					const Vector3f &c1 = triangleArray[i].c1;
+					const Vector3f &c2 = triangleArray[i].c2;
+					fprintf(f,
+							"v %f %f %f %f %f %f\n",
+							triangleArray[i].p0.x,
+							triangleArray[i].p0.y,
+							triangleArray[i].p0.z,
+							c0.r,
+							c0.g,
+							c0.b);
+					fprintf(f,
+							"v %f %f %f %f %f %f\n",
+							triangleArray[i].p1.x,
+							triangleArray[i].p1.y,
+							triangleArray[i].p1.z,
+							c1.r,
+							c1.g,
+							c1.b);
+					fprintf(f,
+							"v %f %f %f %f %f %f\n",
+							triangleArray[i].p2.x,
+							triangleArray[i].p2.y,
+							triangleArray[i].p2.z,
+							c2.r,
+							c2.g,
+							c2.b);
+				}
+
+				for (uint i = 0; i<noTotalTriangles; i++) {
+					fprintf(f, "f %u %u %u\n", vertexOffset + i * 3 + 2 + 1, vertexOffset + i * 3 + 1 + 1, vertexOffset + i * 3 + 0 + 1);
+				}
+
+				if (shouldDelete) delete cpu_triangles;
+				return noTotalTriangles * 3;
+			}
+
+			/// \brief Writes the mesh as a binary little-endian PLY file, with per-vertex colors.
+			///        Indexed meshes write every vertex once, and triangle soups three vertices per
+			///        triangle. The vertices and faces are formatted in parallel, in large chunks, and
+			///        every chunk is written with a single call.
+			void WritePLY(const char *fileName) const
+			{
 				if (noTotalTriangles > noMaxTriangles) {
 					std::stringstream ss;
 					ss << "Unable to save mesh to file [" << fileName << "]. Too many triangles: "
@@ -66,64 +214,62 @@ namespace ITMLib
 					throw std::runtime_error(ss.str());
 				}
 
-				FILE *f = fopen(fileName, "w+");
-
-				if (f != NULL)
+				ORUtils::MemoryBlock<Triangle> *cpu_triangles = triangles;
+				if (!isIndexed && memoryType == MEMORYDEVICE_CUDA)
 				{
-					// TODO(andrei): Do this in chunks. It doesn't seem like the order of the
-					// triangles matters, so we can just launch multiple phases of the meshing
-					// kernel, which runs fast but is memory-hungry, in order to really support
-					// arbitrary-sized maps.
-					printf("Starting to write mesh...\n");
-					for (uint i = 0; i < noTotalTriangles; i++) {
-						if ((i + 1) % 100000 == 0) {
-							printf("Triangle %d/%d\n", i + 1, noTotalTriangles);
-						}
-						const Vector3f &c0 = triangleArray[i].c0;
-						const Vector3f &c1 = triangleArray[i].c1;
-						const Vector3f &c2 = triangleArray[i].c2;
-						fprintf(f,
-								"v %f %f %f %f %f %f\n",
-								triangleArray[i].p0.x,
-								triangleArray[i].p0.y,
-								triangleArray[i].p0.z,
-								c0.r,
-								c0.g,
-								c0.b);
-						fprintf(f,
-								"v %f %f %f %f %f %f\n",
-								triangleArray[i].p1.x,
-								triangleArray[i].p1.y,
-								triangleArray[i].p1.z,
-								c1.r,
-								c1.g,
-								c1.b);
-						fprintf(f,
-								"v %f %f %f %f %f %f\n",
-								triangleArray[i].p2.x,
-								triangleArray[i].p2.y,
-								triangleArray[i].p2.z,
-								c2.r,
-								c2.g,
-								c2.b);
-					}
-
-					for (uint i = 0; i<noTotalTriangles; i++) {
-						fprintf(f, "f %d %d %d\n", i * 3 + 2 + 1, i * 3 + 1 + 1, i * 3 + 0 + 1);
-					}
-					fclose(f);
-
-					printf("Mesh file writing to [%s] complete.\n", fileName);
+					cpu_triangles = new ORUtils::MemoryBlock<Triangle>(noMaxTriangles, MEMORYDEVICE_CPU);
+					cpu_triangles->SetFrom(triangles, ORUtils::MemoryBlock<Triangle>::CUDA_TO_CPU);
 				}
-				else {
+
+				FILE *f = fopen(fileName, "wb");
+				if (f == NULL) {
+					if (cpu_triangles != triangles) delete cpu_triangles;
 					throw std::runtime_error("Could not open file for writing the mesh.\n");
 				}
 
-				if (shouldDelete) delete cpu_triangles;
+				uint noVertices = isIndexed ? noTotalVertices : noTotalTriangles * 3;
+				bool isWritten = WritePLYHeader(f, noVertices, noTotalTriangles) &&
+					WritePLYVertices(f, cpu_triangles->GetData(MEMORYDEVICE_CPU)) && WritePLYFaces(f, 0);
+
+				if (fclose(f) != 0) isWritten = false;
+				if (cpu_triangles != triangles) delete cpu_triangles;
+				if (!isWritten) throw std::runtime_error("Could not write the mesh to the file.\n");
+			}
+
+			/// \brief Writes the header of a binary PLY file as WritePLY does. The counts are padded
+			///        with zeros to countWidth digits, so that a header can be overwritten once the
+			///        final counts are known. Returns false if writing fails.
+			static bool WritePLYHeader(FILE *f, uint noVertices, uint noTriangles, int countWidth = 0)
+			{
+				return fprintf(f, "ply\nformat binary_little_endian 1.0\ncomment Created by InfiniTAM\n"
+						   "element vertex %0*u\nproperty float x\nproperty float y\nproperty float z\n"
+						   "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+						   "element face %0*u\nproperty list uchar int vertex_indices\nend_header\n",
+						countWidth, noVertices, countWidth, noTriangles) > 0;
+			}
+
+			/// \brief Appends the vertices of a mesh in CPU memory to a binary PLY file, in the order
+			///        WritePLY writes them. Returns false if writing fails.
+			bool AppendPLYVertices(FILE *f) const
+			{
+				return WritePLYVertices(f, triangles->GetData(MEMORYDEVICE_CPU));
+			}
+
+			/// \brief Appends the faces of a mesh in CPU memory to the face list of a binary PLY file,
+			///        whose vertex list has vertexOffset vertices before those of this mesh. Returns
+			///        false if writing fails.
+			bool AppendPLYFaces(FILE *f, uint vertexOffset) const
+			{
+				return WritePLYFaces(f, vertexOffset);
 			}
 
 			void WriteSTL(const char *fileName)
 			{
+				if (isIndexed) {
+					WriteIndexedSTL(fileName);
+					return;
+				}
+
 				ORUtils::MemoryBlock<Triangle> *cpu_triangles; bool shoulDelete = false;
 				if (memoryType == MEMORYDEVICE_CUDA)
 				{
@@ -173,14 +319,264 @@ namespace ITMLib
 				if (shoulDelete) delete cpu_triangles;
 			}
 
+			/// \brief Writes an indexed mesh as a binary STL file, which has no shared vertices.
+			void WriteIndexedSTL(const char *fileName) const
+			{
+				const Vertex *vertexArray = vertices->GetData(MEMORYDEVICE_CPU);
+				const uint *indexArray = indices->GetData(MEMORYDEVICE_CPU);
+
+				FILE *f = fopen(fileName, "wb+");
+				if (f == NULL) throw std::runtime_error("Could not open file for writing the mesh.\n");
+
+				bool isWritten = true;
+				for (int i = 0; i < 80; i++) isWritten &= fwrite(" ", sizeof(char), 1, f) == 1;
+				isWritten &= fwrite(&noTotalTriangles, sizeof(int), 1, f) == 1;
+
+				float zero = 0.0f; short attribute = 0;
+				for (uint i = 0; i < noTotalTriangles && isWritten; i++)
+				{
+					isWritten &= fwrite(&zero, sizeof(float), 1, f) == 1;
+					isWritten &= fwrite(&zero, sizeof(float), 1, f) == 1;
+					isWritten &= fwrite(&zero, sizeof(float), 1, f) == 1;
+					for (int k = 2; k >= 0; k--) isWritten &= fwrite(&vertexArray[indexArray[i * 3 + k]].p, sizeof(float), 3, f) == 3;
+					isWritten &= fwrite(&attribute, sizeof(short), 1, f) == 1;
+				}
+
+				if (fclose(f) != 0) isWritten = false;
+				if (!isWritten) throw std::runtime_error("Could not write the mesh to the file.\n");
+			}
+
 			~ITMMesh()
 			{
 				delete triangles;
+				delete vertices;
+				delete indices;
+			}
+
+		private:
+			/// Sizes of a vertex (position and color) and a face (vertex count and indices) in a
+			/// binary PLY file, and how many of them WritePLY formats at once.
+			static const size_t plyVertexSize = 3 * 4 + 3;
+			static const size_t plyFaceSize = 1 + 3 * 4;
+			static const uint plyChunkSize = 1 << 20;
+
+			static void PutLittleEndian(unsigned char *out, uint value)
+			{
+				out[0] = (unsigned char)value; out[1] = (unsigned char)(value >> 8);
+				out[2] = (unsigned char)(value >> 16); out[3] = (unsigned char)(value >> 24);
+			}
+
+			static void PutPLYVertex(unsigned char *record, const Vector3f &p, const Vector3f &c)
+			{
+				for (int axis = 0; axis < 3; axis++) {
+					uint bits;
+					memcpy(&bits, &p.v[axis], sizeof(bits));
+					PutLittleEndian(record + axis * 4, bits);
+				}
+				// The colors are in [0, 255].
+				for (int channel = 0; channel < 3; channel++) {
+					float value = c.v[channel] + 0.5f;
+					record[12 + channel] = (unsigned char)(value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value));
+				}
+			}
+
+			/// Same winding as the other writers.
+			static void PutPLYFace(unsigned char *record, uint i0, uint i1, uint i2)
+			{
+				record[0] = 3;
+				PutLittleEndian(record + 1, i2);
+				PutLittleEndian(record + 5, i1);
+				PutLittleEndian(record + 9, i0);
+			}
+
+			/// \brief Writes the vertices of the mesh, whose triangles, if it is a triangle soup, are
+			///        the given ones in CPU memory.
+			bool WritePLYVertices(FILE *f, const Triangle *triangleArray) const
+			{
+				if (isIndexed) {
+					const Vertex *vertexArray = vertices->GetData(MEMORYDEVICE_CPU);
+					return WritePLYRecords(f, noTotalVertices, plyVertexSize, [=](uint i, unsigned char *record) {
+						PutPLYVertex(record, vertexArray[i].p, vertexArray[i].c);
+					});
+				}
+
+				return WritePLYRecords(f, noTotalTriangles * 3, plyVertexSize, [=](uint i, unsigned char *record) {
+					const Triangle &triangle = triangleArray[i / 3];
+					switch (i % 3) {
+					case 0: PutPLYVertex(record, triangle.p0, triangle.c0); break;
+					case 1: PutPLYVertex(record, triangle.p1, triangle.c1); break;
+					default: PutPLYVertex(record, triangle.p2, triangle.c2); break;
+					}
+				});
+			}
+
+			/// \brief Writes the faces of the mesh, with vertexOffset added to their vertex indices.
+			bool WritePLYFaces(FILE *f, uint vertexOffset) const
+			{
+				if (isIndexed) {
+					const uint *indexArray = indices->GetData(MEMORYDEVICE_CPU);
+					return WritePLYRecords(f, noTotalTriangles, plyFaceSize, [=](uint i, unsigned char *record) {
+						PutPLYFace(record, vertexOffset + indexArray[i * 3], vertexOffset + indexArray[i * 3 + 1],
+							vertexOffset + indexArray[i * 3 + 2]);
+					});
+				}
+
+				return WritePLYRecords(f, noTotalTriangles, plyFaceSize, [=](uint i, unsigned char *record) {
+					PutPLYFace(record, vertexOffset + i * 3, vertexOffset + i * 3 + 1, vertexOffset + i * 3 + 2);
+				});
+			}
+
+			/// \brief Writes noRecords records of recordSize bytes, which format(i, record) puts into
+			///        record. Returns false if writing fails.
+			template<class TFormat>
+			static bool WritePLYRecords(FILE *f, uint noRecords, size_t recordSize, TFormat format)
+			{
+				uint chunkSize = plyChunkSize;
+				std::vector<unsigned char> buffer(MIN(noRecords, chunkSize) * recordSize);
+
+				for (uint chunkBegin = 0; chunkBegin < noRecords; chunkBegin += chunkSize) {
+					int noChunkRecords = (int)MIN(noRecords - chunkBegin, chunkSize);
+					unsigned char *out = buffer.data();
+#ifdef WITH_OPENMP
+					#pragma omp parallel for
+#endif
+					for (int i = 0; i < noChunkRecords; i++) format(chunkBegin + i, out + i * recordSize);
+
+					if (fwrite(out, recordSize, noChunkRecords, f) != (size_t)noChunkRecords) return false;
+				}
+				return true;
 			}
 
+			/// \brief Capacity to grow a buffer to, so that it fits required elements. Grows by at
+			///        least half, so that a slowly growing map does not reallocate every time.
+			static uint GrownCapacity(uint capacity, uint required)
+			{
+				uint grown = capacity + capacity / 2;
+				return grown < required ? required : grown;
+			}
+
+		public:
 			// Suppress the default copy constructor and assignment operator
 			ITMMesh(const ITMMesh&);
 			ITMMesh& operator=(const ITMMesh&);
 		};
+
+		/// \brief Receives a mesh piece by piece, e.g., from ITMMeshingEngine::MeshSceneStreamed.
+		class ITMMeshSink
+		{
+		public:
+			/// \brief Takes the next piece of the mesh, which is in CPU memory. The piece is only
+			///        valid during the call.
+			virtual void Consume(const ITMMesh &piece) = 0;
+
+			virtual ~ITMMeshSink(void) { }
+		};
+
+		/// \brief Hands every piece of a mesh to a function.
+		class ITMMeshCallbackSink : public ITMMeshSink
+		{
+			std::function<void(const ITMMesh&)> callback;
+
+		public:
+			explicit ITMMeshCallbackSink(std::function<void(const ITMMesh&)> callback) : callback(callback) { }
+
+			void Consume(const ITMMesh &piece) override { callback(piece); }
+		};
+
+		/// \brief Writes the pieces of a mesh into one Wavefront OBJ file, as they come.
+		class ITMMeshOBJFileSink : public ITMMeshSink
+		{
+			FILE *f;
+			uint noWrittenVertices;
+			uint noWrittenTriangles;
+
+		public:
+			explicit ITMMeshOBJFileSink(const char *fileName) : noWrittenVertices(0), noWrittenTriangles(0)
+			{
+				f = fopen(fileName, "w+");
+				if (f == NULL) throw std::runtime_error("Could not open file for writing the mesh.\n");
+			}
+
+			void Consume(const ITMMesh &piece) override
+			{
+				noWrittenVertices += piece.AppendOBJ(f, noWrittenVertices);
+				noWrittenTriangles += piece.noTotalTriangles;
+			}
+
+			uint GetNoWrittenTriangles(void) const { return noWrittenTriangles; }
+
+			~ITMMeshOBJFileSink(void) { fclose(f); }
+
+			// Suppress the default copy constructor and assignment operator
+			ITMMeshOBJFileSink(const ITMMeshOBJFileSink&);
+			ITMMeshOBJFileSink& operator=(const ITMMeshOBJFileSink&);
+		};
+
+		/// \brief Writes the pieces of a mesh into one binary PLY file, as they come. The vertices
+		///        go straight into the file, and the faces into a temporary file, which is appended
+		///        to it by Close, as PLY lists all the vertices first. Close also fills in the counts.
+		class ITMMeshPLYFileSink : public ITMMeshSink
+		{
+			static const int countWidth = 10;
+
+			FILE *f;
+			FILE *faceFile;
+			uint noWrittenVertices;
+			uint noWrittenTriangles;
+			bool isWritten;
+
+		public:
+			explicit ITMMeshPLYFileSink(const char *fileName) : noWrittenVertices(0), noWrittenTriangles(0)
+			{
+				f = fopen(fileName, "wb");
+				if (f == NULL) throw std::runtime_error("Could not open file for writing the mesh.\n");
+				faceFile = tmpfile();
+				if (faceFile == NULL) {
+					fclose(f);
+					throw std::runtime_error("Could not open a temporary file for writing the mesh.\n");
+				}
+				isWritten = ITMMesh::WritePLYHeader(f, 0, 0, countWidth);
+			}
+
+			void Consume(const ITMMesh &piece) override
+			{
+				isWritten = isWritten && piece.AppendPLYVertices(f) && piece.AppendPLYFaces(faceFile, noWrittenVertices);
+				noWrittenVertices += piece.isIndexed ? piece.noTotalVertices : piece.noTotalTriangles * 3;
+				noWrittenTriangles += piece.noTotalTriangles;
+			}
+
+			/// \brief Completes the file. Throws if any of it could not be written.
+			void Close(void)
+			{
+				if (f == NULL) return;
+
+				std::vector<char> buffer(1 << 20);
+				isWritten = isWritten && fseek(faceFile, 0, SEEK_SET) == 0;
+				for (size_t noRead; isWritten && (noRead = fread(buffer.data(), 1, buffer.size(), faceFile)) > 0;) {
+					isWritten = fwrite(buffer.data(), 1, noRead, f) == noRead;
+				}
+				isWritten = isWritten && !ferror(faceFile) && fseek(f, 0, SEEK_SET) == 0 &&
+					ITMMesh::WritePLYHeader(f, noWrittenVertices, noWrittenTriangles, countWidth);
+
+				if (fclose(f) != 0) isWritten = false;
+				fclose(faceFile);
+				f = faceFile = NULL;
+				if (!isWritten) throw std::runtime_error("Could not write the mesh to the file.\n");
+			}
+
+			uint GetNoWrittenTriangles(void) const { return noWrittenTriangles; }
+
+			~ITMMeshPLYFileSink(void)
+			{
+				if (f != NULL) {
+					fclose(f);
+					fclose(faceFile);
+				}
+			}
+
+			// Suppress the default copy constructor and assignment operator
+			ITMMeshPLYFileSink(const ITMMeshPLYFileSink&);
+			ITMMeshPLYFileSink& operator=(const ITMMeshPLYFileSink&);
+		};
 	}
 }
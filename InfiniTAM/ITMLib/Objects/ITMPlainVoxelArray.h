@@ -46,7 +46,13 @@ namespace ITMLib
 
 #ifndef __METALC__
 		public:
-			ITMPlainVoxelArray(MemoryDeviceType memoryType)
+			/** The whole volume is a single entry. */
+			const int noTotalEntries;
+
+			/// The hash table sizes are ignored; they keep the signature in line with the hashed
+			/// indices, so that ITMScene can be built on any of them.
+			ITMPlainVoxelArray(MemoryDeviceType memoryType, long sdfLocalBlockNum = 1, long sdfBucketNum = 0, long sdfExcessListSize = 0)
+				: noTotalEntries(1)
 			{
 				this->memoryType = memoryType;
 
@@ -46,6 +46,15 @@ namespace ITMLib
 			ORUtils::Image<int> *fwdProjMissingPoints;
 			int noFwdProjMissingPoints;
 
+			/// Camera and scene version (see ITMLocalVBA::GetVersion) of the last full raycast of an
+			/// incremental render (see IITMVisualisationEngine::RenderImageIncremental), and how many
+			/// times in a row raycastResult was forward projected since then. -1 if there is no such
+			/// raycast.
+			Matrix4f incrementalInvM;
+			Vector4f incrementalProjParams;
+			unsigned int incrementalSceneVersion;
+			int noIncrementalUpdates;
+
 			// Used for most visualization operations, whose output is typcally 8-bit RGB(A).
 			ORUtils::Image<Vector4u> *raycastImage;
 			// Used for depth map rendering
@@ -76,6 +85,8 @@ namespace ITMLib
 				delete buffImage;
 
 				noFwdProjMissingPoints = 0;
+				incrementalSceneVersion = 0;
+				noIncrementalUpdates = -1;
 			}
 
 			virtual ~ITMRenderState()
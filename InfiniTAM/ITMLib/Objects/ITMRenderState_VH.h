@@ -60,6 +60,18 @@ namespace ITMLib
 			*/
 			uchar *GetEntriesVisibleType(void) { return entriesVisibleType->GetData(memoryType); }
 
+			/** Makes room for the visible types of a hash table which has grown. The types are
+			cleared when the list is reallocated.
+			*/
+			void ResizeEntriesVisibleType(int noTotalEntries)
+			{
+				if (entriesVisibleType->dataSize >= static_cast<size_t>(noTotalEntries)) return;
+
+				delete entriesVisibleType;
+				entriesVisibleType = new ORUtils::MemoryBlock<uchar>(noTotalEntries, memoryType);
+				entriesVisibleType->Clear();
+			}
+
 #ifdef COMPILE_WITH_METAL
 			const void* GetVisibleEntryIDs_MB(void) { return visibleEntryIDs->GetMetalBuffer(); }
 			const void* GetEntriesVisibleType_MB(void) { return entriesVisibleType->GetMetalBuffer(); }
@@ -35,13 +35,14 @@ namespace ITMLib
 			ITMGlobalCache<TVoxel> *globalCache;
 
 			ITMScene(const ITMSceneParams *sceneParams, bool useSwapping,
-					 MemoryDeviceType memoryType, long sdfLocalBlockNum)
-				: index(memoryType, sdfLocalBlockNum),
+					 MemoryDeviceType memoryType, long sdfLocalBlockNum,
+					 long sdfBucketNum = DEFAULT_SDF_BUCKET_NUM, long sdfExcessListSize = DEFAULT_SDF_EXCESS_LIST_SIZE)
+				: index(memoryType, sdfLocalBlockNum, sdfBucketNum, sdfExcessListSize),
 				  localVBA(memoryType, index.getNumAllocatedVoxelBlocks(), index.getVoxelBlockSize())
 			{
 				this->sceneParams = sceneParams;
 				this->useSwapping = useSwapping;
-				if (useSwapping) globalCache = new ITMGlobalCache<TVoxel>();
+				if (useSwapping) globalCache = new ITMGlobalCache<TVoxel>(index.noTotalEntries);
 			}
 
 			~ITMScene(void)
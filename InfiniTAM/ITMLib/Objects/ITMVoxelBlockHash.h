@@ -4,6 +4,7 @@
 
 #ifndef __METALC__
 #include <stdlib.h>
+#include <stdexcept>
 #endif
 
 #include "../Utils/ITMLibDefines.h"
@@ -22,7 +23,36 @@ namespace ITMLib
 		class ITMVoxelBlockHash
 		{
 		public:
-			typedef ITMHashEntry IndexData;
+			/** \brief
+			    Describes the hash table to the device-agnostic lookup code. Lives in the same
+			    memory as the hash table itself.
+			*/
+			struct ITMHashTableInfo {
+				/// The hash entries: bucketNum ordered entries followed by excessListSize excess entries.
+				DEVICEPTR(ITMHashEntry) *entries;
+				/// Number of hash buckets; a power of two.
+				int bucketNum;
+				/// Used to get the bucket index from a hash value; equal to bucketNum - 1.
+				int hashMask;
+				/// Size of the excess list, used to handle collisions.
+				int excessListSize;
+
+				/// While the table grows, the entries of the previous, smaller table, whose blocks have
+				/// not all been migrated yet. NULL otherwise. See ITMVoxelBlockHash::BeginGrowth.
+				DEVICEPTR(ITMHashEntry) *oldEntries;
+				/// Number of buckets of the previous table.
+				int oldBucketNum;
+				/// Equal to oldBucketNum - 1.
+				int oldHashMask;
+
+				/// Number of blocks in the table in every brick of the occupancy grid, and in every
+				/// sector; see occupancyGridSize. Lets the raycaster skip empty space. NULL unless the
+				/// grid is enabled; see ITMVoxelBlockHash::SetOccupancyGrid.
+				DEVICEPTR(int) *brickOccupancy;
+				DEVICEPTR(int) *sectorOccupancy;
+			};
+
+			typedef ITMHashTableInfo IndexData;
 
 			struct IndexCache {
 				Vector3i blockPos;
@@ -30,10 +60,17 @@ namespace ITMLib
 				_CPU_AND_GPU_CODE_ IndexCache(void) : blockPos(0x7fffffff), blockPtr(-1) {}
 			};
 
-			/** Maximum number of total entries. */
-			static const CONSTPTR(int) noTotalEntries = SDF_BUCKET_NUM + SDF_EXCESS_LIST_SIZE;
 			static const CONSTPTR(int) voxelBlockSize = SDF_BLOCK_SIZE * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
 
+			/// The occupancy grid has occupancyGridSize^3 bricks of occupancyBrickSize^3 blocks, and
+			/// groups them into sectors of occupancySectorSize^3 bricks. It wraps around: a brick
+			/// counts the blocks of all the bricks of space which are a multiple of occupancyGridSize
+			/// bricks away from it along every axis. With 5mm voxels, the grid spans 20m along every
+			/// axis, so scenes up to that size anywhere in space have no bricks which share a count.
+			static const CONSTPTR(int) occupancyBrickSize = 4;
+			static const CONSTPTR(int) occupancySectorSize = 4;
+			static const CONSTPTR(int) occupancyGridSize = 128;
+
 #ifndef __METALC__
 		private:
 			int lastFreeExcessListId;
@@ -47,30 +84,186 @@ namespace ITMLib
 			overflow.
 			*/
 			ORUtils::MemoryBlock<int> *excessAllocationList;
+
+			/** Sizes of the table and a pointer to its entries, stored on the same device. */
+			ORUtils::MemoryBlock<IndexData> *indexData;
+
+			/** Block counts of the bricks and of the sectors of the occupancy grid; NULL unless the
+			    grid is enabled. */
+			ORUtils::MemoryBlock<int> *brickOccupancy;
+			ORUtils::MemoryBlock<int> *sectorOccupancy;
+
+			/** While the table grows, the previous table, which is being migrated. */
+			ORUtils::MemoryBlock<ITMHashEntry> *oldHashEntries;
+			int oldBucketNum;
+			int oldNoTotalEntries;
+			/** Buckets of the previous table before this one have already been migrated. */
+			int nextMigratedBucket;
         
 			MemoryDeviceType memoryType;
 			int sdfLocalBlockNum;
+			int bucketNum;
+			int excessListSize;
+
+			void UpdateIndexData(void)
+			{
+				IndexData *info = indexData->GetData(MEMORYDEVICE_CPU);
+				info->entries = hashEntries->GetData(memoryType);
+				info->bucketNum = bucketNum;
+				info->hashMask = bucketNum - 1;
+				info->excessListSize = excessListSize;
+				info->oldEntries = (oldHashEntries != NULL) ? oldHashEntries->GetData(memoryType) : NULL;
+				info->oldBucketNum = oldBucketNum;
+				info->oldHashMask = oldBucketNum - 1;
+				info->brickOccupancy = (brickOccupancy != NULL) ? brickOccupancy->GetData(memoryType) : NULL;
+				info->sectorOccupancy = (sectorOccupancy != NULL) ? sectorOccupancy->GetData(memoryType) : NULL;
+				indexData->UpdateDeviceFromHost();
+			}
 
 		public:
-			ITMVoxelBlockHash(MemoryDeviceType memoryType, int sdfLocalBlockNum)
-				: memoryType(memoryType), sdfLocalBlockNum(sdfLocalBlockNum)
+			/** Maximum number of total entries: bucketNum + excessListSize. Changes when the table
+			    grows. */
+			int noTotalEntries;
+
+			ITMVoxelBlockHash(MemoryDeviceType memoryType, int sdfLocalBlockNum,
+							  int bucketNum = DEFAULT_SDF_BUCKET_NUM, int excessListSize = DEFAULT_SDF_EXCESS_LIST_SIZE)
+				: brickOccupancy(NULL), sectorOccupancy(NULL), oldHashEntries(NULL), oldBucketNum(0), oldNoTotalEntries(0), nextMigratedBucket(0),
+				  memoryType(memoryType), sdfLocalBlockNum(sdfLocalBlockNum),
+				  bucketNum(bucketNum), excessListSize(excessListSize),
+				  noTotalEntries(bucketNum + excessListSize)
 			{
+				if (bucketNum <= 0 || (bucketNum & (bucketNum - 1)) != 0) {
+					throw std::runtime_error("The number of hash buckets must be a power of two.");
+				}
+				if (excessListSize <= 0) {
+					throw std::runtime_error("The excess list size must be positive.");
+				}
+
 				hashEntries = new ORUtils::MemoryBlock<ITMHashEntry>(noTotalEntries, memoryType);
-				excessAllocationList = new ORUtils::MemoryBlock<int>(SDF_EXCESS_LIST_SIZE, memoryType);
+				excessAllocationList = new ORUtils::MemoryBlock<int>(excessListSize, memoryType);
+
+				indexData = new ORUtils::MemoryBlock<IndexData>(1, true, memoryType == MEMORYDEVICE_CUDA);
+				UpdateIndexData();
 			}
 
 			~ITMVoxelBlockHash(void)
 			{
 				delete hashEntries;
 				delete excessAllocationList;
+				delete indexData;
+				delete oldHashEntries;
+				delete brickOccupancy;
+				delete sectorOccupancy;
+			}
+
+			/** \brief Allocates the occupancy grid (8MiB), or frees it. Only the CPU engines keep
+			    track of the occupancy, so tables in other memory never get a grid. The grid starts
+			    out empty, and only counts the blocks added from then on, so it is to be enabled on an
+			    empty table, e.g., when the scene is reset. */
+			void SetOccupancyGrid(bool isEnabled)
+			{
+				if (memoryType != MEMORYDEVICE_CPU) isEnabled = false;
+				if (isEnabled == (brickOccupancy != NULL)) return;
+
+				delete brickOccupancy;
+				delete sectorOccupancy;
+				brickOccupancy = sectorOccupancy = NULL;
+				if (isEnabled) {
+					int noSectors = occupancyGridSize / occupancySectorSize;
+					brickOccupancy = new ORUtils::MemoryBlock<int>(occupancyGridSize * occupancyGridSize * occupancyGridSize, memoryType);
+					sectorOccupancy = new ORUtils::MemoryBlock<int>(noSectors * noSectors * noSectors, memoryType);
+					ClearOccupancy();
+				}
+				UpdateIndexData();
+			}
+
+			/** Marks the whole occupancy grid as empty, e.g., when the scene is reset. */
+			void ClearOccupancy(void)
+			{
+				if (brickOccupancy != NULL) brickOccupancy->Clear();
+				if (sectorOccupancy != NULL) sectorOccupancy->Clear();
+			}
+
+			/** \brief Replaces the table with an empty one with more buckets and a larger excess
+			    list, keeping the current table around until its blocks have been migrated.
+
+			    While the table grows, lookups which fail in the new table fall back to the old one,
+			    so the scene stays complete. The engine moves the blocks over in batches of buckets
+			    (see GetNextMigratedBucket), marking each migrated entry as free in the old table,
+			    and calls FinishGrowth once all old buckets have been processed. Entry IDs change,
+			    so anything indexed by them (e.g., the visible entry types of the render states)
+			    has to be resized and rebuilt. Only supported for tables in CPU memory.
+			*/
+			void BeginGrowth(int newBucketNum, int newExcessListSize)
+			{
+				if (memoryType != MEMORYDEVICE_CPU) {
+					throw std::runtime_error("Only hash tables in CPU memory can grow.");
+				}
+				if (IsGrowing()) {
+					throw std::runtime_error("The hash table is already growing.");
+				}
+				if (newBucketNum <= bucketNum || (newBucketNum & (newBucketNum - 1)) != 0 || newExcessListSize <= 0) {
+					throw std::runtime_error("A hash table can only grow to a larger power of two number "
+											 "of buckets.");
+				}
+
+				oldHashEntries = hashEntries;
+				oldBucketNum = bucketNum;
+				oldNoTotalEntries = noTotalEntries;
+				nextMigratedBucket = 0;
+
+				bucketNum = newBucketNum;
+				excessListSize = newExcessListSize;
+				noTotalEntries = bucketNum + excessListSize;
+
+				hashEntries = new ORUtils::MemoryBlock<ITMHashEntry>(noTotalEntries, memoryType);
+				ITMHashEntry *entries = hashEntries->GetData(MEMORYDEVICE_CPU);
+				for (int i = 0; i < noTotalEntries; ++i) {
+					entries[i].pos = Vector3s(0, 0, 0);
+					entries[i].offset = 0;
+					entries[i].ptr = -2;
+					entries[i].allocatedTime = 0;
+				}
+
+				delete excessAllocationList;
+				excessAllocationList = new ORUtils::MemoryBlock<int>(excessListSize, memoryType);
+				int *excessList = excessAllocationList->GetData(MEMORYDEVICE_CPU);
+				for (int i = 0; i < excessListSize; ++i) excessList[i] = i;
+				lastFreeExcessListId = excessListSize - 1;
+
+				UpdateIndexData();
+			}
+
+			/** Releases the previous table, once all its blocks have been migrated. */
+			void FinishGrowth(void)
+			{
+				delete oldHashEntries;
+				oldHashEntries = NULL;
+				oldBucketNum = 0;
+				oldNoTotalEntries = 0;
+				nextMigratedBucket = 0;
+				UpdateIndexData();
 			}
 
+			bool IsGrowing(void) const { return oldHashEntries != NULL; }
+
+			/** While the table grows, the entries of the previous table; NULL otherwise. Migrated
+			    entries are marked as free, so every entry with ptr >= 0 still has to be moved. */
+			const ITMHashEntry *GetOldEntries(void) const { return IsGrowing() ? oldHashEntries->GetData(memoryType) : NULL; }
+			ITMHashEntry *GetOldEntries(void) { return IsGrowing() ? oldHashEntries->GetData(memoryType) : NULL; }
+			/** Number of entries in the previous table; 0 if the table is not growing. */
+			int getOldNoTotalEntries(void) const { return oldNoTotalEntries; }
+			int getOldBucketNum(void) const { return oldBucketNum; }
+
+			int GetNextMigratedBucket(void) const { return nextMigratedBucket; }
+			void SetNextMigratedBucket(int nextMigratedBucket) { this->nextMigratedBucket = nextMigratedBucket; }
+
 			/** Get the list of actual entries in the hash table. */
 			const ITMHashEntry *GetEntries(void) const { return hashEntries->GetData(memoryType); }
 			ITMHashEntry *GetEntries(void) { return hashEntries->GetData(memoryType); }
 
-			const IndexData *getIndexData(void) const { return hashEntries->GetData(memoryType); }
-			IndexData *getIndexData(void) { return hashEntries->GetData(memoryType); }
+			/** Get the table description used by the device-agnostic lookup code (findVoxel, readVoxel, ...). */
+			const IndexData *getIndexData(void) const { return indexData->GetData(memoryType); }
 
 			/** Get the list that identifies which entries of the
 			overflow list are allocated. This is used if too
@@ -85,13 +278,18 @@ namespace ITMLib
 #ifdef COMPILE_WITH_METAL
 			const void* GetEntries_MB(void) { return hashEntries->GetMetalBuffer(); }
 			const void* GetExcessAllocationList_MB(void) { return excessAllocationList->GetMetalBuffer(); }
-			const void* getIndexData_MB(void) const { return hashEntries->GetMetalBuffer(); }
+			const void* getIndexData_MB(void) const { return indexData->GetMetalBuffer(); }
 #endif
 
 			/** Maximum number of total entries. */
 			int getNumAllocatedVoxelBlocks(void) { return sdfLocalBlockNum; }
 			int getVoxelBlockSize(void) { return SDF_BLOCK_SIZE3; }
 
+			/** Number of hash buckets, i.e., of entries in the ordered part of the table. */
+			int getBucketNum(void) const { return bucketNum; }
+			/** Number of entries in the excess list. */
+			int getExcessListSize(void) const { return excessListSize; }
+
 			// Suppress the default copy constructor and assignment operator
 			ITMVoxelBlockHash(const ITMVoxelBlockHash&);
 			ITMVoxelBlockHash& operator=(const ITMVoxelBlockHash&);
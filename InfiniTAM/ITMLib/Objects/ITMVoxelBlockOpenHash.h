@@ -0,0 +1,144 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#ifndef __METALC__
+#include <stdlib.h>
+#include <stdexcept>
+#endif
+
+#include "../Utils/ITMLibDefines.h"
+
+#include "../../ORUtils/MemoryBlock.h"
+
+/// Number of consecutive slots inspected per step when probing the open-addressing hash table.
+/// Must be a power of two. The slots of a group are adjacent, so inspecting one touches one or two
+/// cache lines, and the fixed-size inner loop can be unrolled by the compiler.
+#define SDF_OPEN_HASH_GROUP_SIZE 4
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		Voxel block hash table using open addressing instead of
+		bucket chaining. Can be used instead of ITMVoxelBlockHash
+		as the TIndex of a scene.
+
+		Blocks are stored directly in the table. A lookup starts at
+		the group of SDF_OPEN_HASH_GROUP_SIZE slots containing the
+		hashed slot and moves on to the next group (linear probing)
+		until it finds the block or a group with an empty slot. There
+		is no excess list which can run out, and collisions do not
+		require chasing 'offset' links through a separate part of the
+		table.
+
+		Entries never move once inserted, so entry IDs stay valid
+		across frames, like in ITMVoxelBlockHash. The 'offset' field
+		of the entries is unused. Deleting entries (voxel decay) and
+		swapping are not supported.
+		*/
+		class ITMVoxelBlockOpenHash
+		{
+		public:
+			/** \brief
+			    Describes the table to the device-agnostic lookup code. Lives in the same memory
+			    as the table itself.
+			*/
+			struct ITMOpenHashTableInfo {
+				/// The slots of the table.
+				DEVICEPTR(ITMHashEntry) *entries;
+				/// Number of slots; a power of two.
+				int slotNum;
+				/// Used to get the slot index from a hash value; equal to slotNum - 1.
+				int slotMask;
+			};
+
+			typedef ITMOpenHashTableInfo IndexData;
+
+			struct IndexCache {
+				Vector3i blockPos;
+				int blockPtr;
+				_CPU_AND_GPU_CODE_ IndexCache(void) : blockPos(0x7fffffff), blockPtr(-1) {}
+			};
+
+			static const CONSTPTR(int) voxelBlockSize = SDF_BLOCK_SIZE * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+
+#ifndef __METALC__
+		private:
+			/** The actual data in the hash table. */
+			ORUtils::MemoryBlock<ITMHashEntry> *hashEntries;
+
+			/** Size of the table and a pointer to its entries, stored on the same device. */
+			ORUtils::MemoryBlock<IndexData> *indexData;
+
+			MemoryDeviceType memoryType;
+			int sdfLocalBlockNum;
+
+		public:
+			/** Number of slots in the table. */
+			const int noTotalEntries;
+
+			/** The table has 'slotNum' slots. The last argument only exists so that the
+			    constructor matches the one of ITMVoxelBlockHash. There is no excess list, so
+			    it must be 0.
+			*/
+			ITMVoxelBlockOpenHash(MemoryDeviceType memoryType, int sdfLocalBlockNum,
+								  int slotNum = DEFAULT_SDF_BUCKET_NUM, int excessListSize = 0)
+				: memoryType(memoryType), sdfLocalBlockNum(sdfLocalBlockNum), noTotalEntries(slotNum)
+			{
+				if (slotNum < SDF_OPEN_HASH_GROUP_SIZE || (slotNum & (slotNum - 1)) != 0) {
+					throw std::runtime_error("The number of slots of an open-addressing hash table must be a "
+											 "power of two.");
+				}
+				if (excessListSize != 0) {
+					throw std::runtime_error("An open-addressing hash table has no excess list; its size "
+											 "must be 0.");
+				}
+				if (sdfLocalBlockNum >= slotNum) {
+					throw std::runtime_error("An open-addressing hash table needs more slots than there are "
+											 "voxel blocks.");
+				}
+
+				hashEntries = new ORUtils::MemoryBlock<ITMHashEntry>(noTotalEntries, memoryType);
+
+				indexData = new ORUtils::MemoryBlock<IndexData>(1, true, memoryType == MEMORYDEVICE_CUDA);
+				IndexData *info = indexData->GetData(MEMORYDEVICE_CPU);
+				info->entries = hashEntries->GetData(memoryType);
+				info->slotNum = slotNum;
+				info->slotMask = slotNum - 1;
+				indexData->UpdateDeviceFromHost();
+			}
+
+			~ITMVoxelBlockOpenHash(void)
+			{
+				delete hashEntries;
+				delete indexData;
+			}
+
+			/** Get the list of actual entries in the hash table. */
+			const ITMHashEntry *GetEntries(void) const { return hashEntries->GetData(memoryType); }
+			ITMHashEntry *GetEntries(void) { return hashEntries->GetData(memoryType); }
+
+			/** Get the table description used by the device-agnostic lookup code (findVoxel, readVoxel, ...). */
+			const IndexData *getIndexData(void) const { return indexData->GetData(memoryType); }
+
+			/** Maximum number of total entries. */
+			int getNumAllocatedVoxelBlocks(void) { return sdfLocalBlockNum; }
+			int getVoxelBlockSize(void) { return SDF_BLOCK_SIZE3; }
+
+			/** Number of slots in the table. */
+			int getSlotNum(void) const { return noTotalEntries; }
+
+			/** Open-addressing tables do not grow, so there is never a previous table to migrate
+			    blocks from; see ITMVoxelBlockHash::GetOldEntries. */
+			const ITMHashEntry *GetOldEntries(void) const { return NULL; }
+			int getOldNoTotalEntries(void) const { return 0; }
+
+			// Suppress the default copy constructor and assignment operator
+			ITMVoxelBlockOpenHash(const ITMVoxelBlockOpenHash&);
+			ITMVoxelBlockOpenHash& operator=(const ITMVoxelBlockOpenHash&);
+#endif
+		};
+	}
+}
@@ -36,28 +36,29 @@
 #define SDF_BLOCK_SIZE 8				// SDF block size
 #define SDF_BLOCK_SIZE3 512				// SDF_BLOCK_SIZE3 = SDF_BLOCK_SIZE * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE
 
+/// Order of the voxels inside a block. 0 stores them x-fastest (x + y * 8 + z * 64). 1 stores them
+/// in Z-order (Morton order), i.e., with the bits of x, y and z interleaved, so that every 2x2x2
+/// cell of a block is contiguous in memory and a trilinear read touches a single cache line most of
+/// the time. All in-block offsets go through voxelBlockLocalIdx and voxelBlockLocalPos.
+#ifndef SDF_BLOCK_MORTON_ORDER
+#define SDF_BLOCK_MORTON_ORDER 0
+#endif
+
 #define SDF_TRANSFER_BLOCK_NUM 0x1000	// Maximum number of blocks transfered in one swap operation
 
-//#define SDF_BUCKET_NUM 0x100000			// Number of Hash Bucket, should be 2^n and bigger than kDefaultSdfLocalBlockNum, SDF_HASH_MASK = SDF_BUCKET_NUM - 1
-const long SDF_BUCKET_NUM = 0x100000;
+// Default sizes of the voxel hash table. Every ITMVoxelBlockHash carries its own sizes, which are
+// set via ITMLibSettings, so that, e.g., small object reconstructions can use much smaller tables.
 
-//#define SDF_HASH_MASK 0xfffff			// Used for get hashing value of the bucket index,  SDF_HASH_MASK = SDF_BUCKET_NUM - 1
-const long SDF_HASH_MASK = SDF_BUCKET_NUM - 1;
+/// Default number of hash buckets. Must be a power of two, since the hash function masks its
+/// result with (bucket count - 1).
+const long DEFAULT_SDF_BUCKET_NUM = 0x100000;
 
-// TODO(andrei): Un-definify this so each ITM instance can have its own.
+/// Default size of the excess list, used to handle collisions.
 // Note: setting this too large (e.g., 0x80000) can lead to strange memory access violations in the
 // visualization engine. I'm not 100% sure why those happen; it may be some weird interplay between
 // this and MAX_RENDERING_BLOCKS. Or it may just be some other, even darker bug which is otherwise
 // concealed by using smaller buffer sizes.
-#define SDF_EXCESS_LIST_SIZE 0x80000	// 0x20000 Size of excess list, used to handle collisions. Also max offset (unsigned short) value.
-#define SDF_GLOBAL_BLOCK_NUM (SDF_BUCKET_NUM + SDF_EXCESS_LIST_SIZE)	// Number of globally stored blocks: SDF_BUCKET_NUM + SDF_EXCESS_LIST_SIZE
-
-//#define SDF_EXCESS_LIST_SIZE 0x10000
-//const long SDF_EXCESS_LIST_SIZE = 0x4000;
-
-//#define SDF_BUCKET_NUM 0x800000
-//#define SDF_HASH_MASK (SDF_BUCKET_NUM - 1)
-//#define SDF_EXCESS_LIST_SIZE 0x20000
+const long DEFAULT_SDF_EXCESS_LIST_SIZE = 0x80000;
 
 //////////////////////////////////////////////////////////////////////////
 // Voxel Hashing data structures
@@ -97,6 +98,7 @@ struct ITMHashSwapState
 
 #include "../Objects/ITMVoxelBlockHash.h"
 #include "../Objects/ITMPlainVoxelArray.h"
+#include "../Objects/ITMVoxelBlockOpenHash.h"
 
 /** \brief
     Stores the information of a single voxel in the volume
@@ -222,24 +224,74 @@ struct ITMVoxel_f
 	}
 };
 
+/** \brief
+    Stores the geometry of a voxel in two bytes, for large maps which are memory-bound.
+
+    The SDF is quantized to 8 bits over the truncation band, i.e., one step is mu / 127, and the
+    values are rounded rather than truncated, since truncating such coarse steps biases the
+    surface towards the camera. Compared to ITMVoxel_s, twice as many blocks fit in the same
+    memory; see InfiniTAM_voxelreport for the accuracy this costs.
+*/
+struct ITMVoxel_u8
+{
+	_CPU_AND_GPU_CODE_ static signed char SDF_initialValue() { return 127; }
+	_CPU_AND_GPU_CODE_ static float SDF_valueToFloat(float x) { return (float)(x) / 127.0f; }
+	_CPU_AND_GPU_CODE_ static signed char SDF_floatToValue(float x) { return (signed char)((x) * 127.0f + ((x) < 0.0f ? -0.5f : 0.5f)); }
+
+	static const CONSTPTR(bool) hasColorInformation = false;
+
+	/** Value of the truncated signed distance transformation. */
+	signed char sdf;
+	/** Number of fused observations that make up @p sdf. */
+	uchar w_depth;
+
+	_CPU_AND_GPU_CODE_ ITMVoxel_u8()
+	{
+		reset();
+	}
+
+	_CPU_AND_GPU_CODE_ void reset()
+	{
+		sdf = SDF_initialValue();
+		w_depth = 0;
+	}
+};
+
 /**
  * This chooses the information stored at each voxel. At the moment, valid
-   options are ITMVoxel_s, ITMVoxel_f, ITMVoxel_s_rgb and ITMVoxel_f_rgb.
+   options are ITMVoxel_s, ITMVoxel_f, ITMVoxel_u8, ITMVoxel_s_rgb and ITMVoxel_f_rgb.
    See above for details on these formats.
 */
 //typedef ITMVoxel_s ITMVoxel;
 //typedef ITMVoxel_f ITMVoxel;
+//typedef ITMVoxel_u8 ITMVoxel;
 // Float-based representations seem to be noisier and have more holes than the short ones.
 typedef ITMVoxel_s_rgb ITMVoxel;
 //typedef ITMVoxel_f_rgb ITMVoxel;
 // TODO(andrei): Would it be nontrivial to compile all the options and
 // have a commandline argument pick the voxel representation?
 
-/** This chooses the way the voxels are addressed and indexed. At the moment,
-    valid options are ITMVoxelBlockHash and ITMPlainVoxelArray.
+/** This chooses the way the voxels are addressed and indexed, by setting
+    ITM_VOXEL_INDEX to one of the values below. At the moment, valid options are
+    ITMVoxelBlockHash, ITMVoxelBlockOpenHash (CPU only, no swapping or voxel
+    decay, and no excess list, so sdfExcessListSize must be 0) and
+    ITMPlainVoxelArray. The CPU engines are also instantiated for the indices
+    which are not ITMVoxelIndex, as long as they support them.
 */
+#define ITM_VOXEL_INDEX_HASH 0
+#define ITM_VOXEL_INDEX_OPEN_HASH 1
+#define ITM_VOXEL_INDEX_PLAIN 2
+#ifndef ITM_VOXEL_INDEX
+#define ITM_VOXEL_INDEX ITM_VOXEL_INDEX_HASH
+#endif
+
+#if ITM_VOXEL_INDEX == ITM_VOXEL_INDEX_OPEN_HASH
+typedef ITMLib::Objects::ITMVoxelBlockOpenHash ITMVoxelIndex;
+#elif ITM_VOXEL_INDEX == ITM_VOXEL_INDEX_PLAIN
+typedef ITMLib::Objects::ITMPlainVoxelArray ITMVoxelIndex;
+#else
 typedef ITMLib::Objects::ITMVoxelBlockHash ITMVoxelIndex;
-//typedef ITMLib::Objects::ITMPlainVoxelArray ITMVoxelIndex;
+#endif
 
 #include "../../ORUtils/Image.h"
 
@@ -113,6 +113,18 @@ ITMLibSettings::ITMLibSettings()
 	groundTruthPoseOffset = 0;
 
 	sdfLocalBlockNum = 0x60000; 		// Original: 0x40000
+	sdfBucketNum = DEFAULT_SDF_BUCKET_NUM;
+	// Open-addressing hash tables resolve collisions in place, without an excess list.
+	sdfExcessListSize = (ITM_VOXEL_INDEX == ITM_VOXEL_INDEX_OPEN_HASH) ? 0 : DEFAULT_SDF_EXCESS_LIST_SIZE;
+	growHashTable = false;
+	hashGrowthBucketsPerFrame = 0x8000;
+	useOccupancyGrid = false;
+	useIncrementalFreeviewRendering = false;
+	incrementalRenderingMaxTranslation = 0.05f;
+	incrementalRenderingMaxRotation = 0.05f;
+	incrementalRenderingRefreshInterval = 30;
+	raycastSubsampling = 1;
+	raycastDiscontinuityThreshold = 0.03f;
 }
 
 ITMLibSettings::~ITMLibSettings()
@@ -90,9 +90,67 @@ namespace ITMLib
 			/// This imposes a hard limit on the maximum
 			long sdfLocalBlockNum;
 
+			/// \brief The number of buckets in the voxel hash table. Must be a power of two.
+			/// Together with sdfExcessListSize, this determines the size of the hash table and of
+			/// the per-entry buffers used by the engines, so small reconstructions (e.g., of
+			/// individual objects) can use much smaller values than the defaults.
+			long sdfBucketNum;
+
+			/// \brief The number of entries in the excess list of the hash table, which is used
+			/// to handle collisions. Must be 0 with ITMVoxelBlockOpenHash, which has none.
+			long sdfExcessListSize;
+
+			/// \brief Whether to grow the hash table (doubling both of the sizes above) when it
+			/// fills up, instead of failing once the excess list runs out. The blocks are migrated
+			/// over several frames. Only supported on the CPU, and without swapping. Voxel decay
+			/// completes a running migration at once, as it only sees the migrated blocks.
+			bool growHashTable;
+
+			/// \brief Number of buckets migrated per frame while the hash table grows.
+			int hashGrowthBucketsPerFrame;
+
+			/// \brief Whether to keep a coarse grid of which parts of space have any voxel blocks,
+			/// which lets the raycaster skip empty space in large steps. Takes 8MiB. Only supported
+			/// by the CPU engine with the chained hash table; see ITMVoxelBlockHash::SetOccupancyGrid.
+			bool useOccupancyGrid;
+
+			/// \brief Whether the free camera views are rendered incrementally: the previous raycast is
+			/// forward projected into the new view, and only the pixels it leaves uncovered are raycast.
+			/// A full raycast is done instead once the camera moved more than the thresholds below since
+			/// the previous view, or after a number of incremental updates in a row, as the forward
+			/// projected points go stale. Only supported by the CPU engine.
+			bool useIncrementalFreeviewRendering;
+			/// \brief Largest camera translation (m) and rotation (rad) from the last fully raycast
+			/// free camera view for which a view is rendered incrementally. Views after the scene
+			/// changed are always raycast in full.
+			float incrementalRenderingMaxTranslation;
+			float incrementalRenderingMaxRotation;
+			/// \brief Number of incremental free camera views after which a full raycast is done.
+			int incrementalRenderingRefreshInterval;
+
+			/// \brief Trades rendering quality for speed: the images rendered for display, and the
+			/// ICP maps used by the trackers, are raycast at 1/raycastSubsampling of their resolution
+			/// along each axis (1, the default, for every pixel; 2 or 4 are sensible), and then
+			/// upsampled. Pixels next to depth discontinuities are raycast regardless. Only
+			/// supported by the CPU engine.
+			int raycastSubsampling;
+			/// \brief Relative depth difference between neighbouring samples above which the pixels
+			/// between them are raycast instead of interpolated, when raycastSubsampling > 1.
+			float raycastDiscontinuityThreshold;
+
 			// Whether to create all the things required for marching cubes and mesh extraction.
 			// - uses additional memory (lots!)
 			bool createMeshingEngine = true;
+			// Whether the CPU meshing engine produces an indexed mesh, whose vertices are shared by
+			// the triangles around them, instead of a triangle soup. Takes about a third of the
+			// memory, and is only allocated once the size of the mesh is known. Off by default, as
+			// consumers of ITMMesh::triangles only see the soup. Ignored on CUDA.
+			bool createIndexedMesh = false;
+			// Whether the CPU meshing engine keeps the mesh of every voxel block, and only meshes the
+			// blocks which changed since the last mesh again. Speeds up meshing the scene repeatedly,
+			// e.g., on every frame, at the cost of about the memory of the mesh. Only supported by the
+			// CPU engine with a hashed scene.
+			bool useIncrementalMeshing = false;
 
 			// maxW gets set to this when dynamic fusion weights (which depend on the depth of each
 			// measurement) are enabled.
@@ -0,0 +1,93 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+namespace ORUtils
+{
+
+/**
+ * \brief Parallel stream compaction (flag, exclusive scan, scatter) on the CPU.
+ *
+ * The input range is split into one contiguous chunk per thread. Every thread flags the elements
+ * of its chunk, the per-chunk counts are turned into output offsets using an exclusive scan, and
+ * every thread then scatters its selected elements starting at its offset. The output therefore
+ * preserves the input order and does not depend on the number of threads.
+ *
+ * \param noElements  The size of the input range [0, noElements).
+ * \param isSelected  Called exactly once for every input index; returns whether the element is kept.
+ *                    It may have side effects on the element it is called for.
+ * \param scatter     Called as scatter(outputIdx, inputIdx) for every kept element.
+ * \param maxOutput   The capacity of the output. Selected elements past it are not scattered.
+ * \return            The number of elements which were scattered, i.e., at most maxOutput.
+ */
+template <typename TPredicate, typename TScatter>
+int compactStream(int noElements, TPredicate isSelected, TScatter scatter,
+				  int maxOutput = std::numeric_limits<int>::max())
+{
+	int maxThreads = 1;
+#ifdef WITH_OPENMP
+	maxThreads = omp_get_max_threads();
+#endif
+	std::vector<int> chunkOffsets(maxThreads + 1, 0);
+	int noSelected = 0;
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel
+#endif
+	{
+		int threadId = 0, noThreads = 1;
+#ifdef WITH_OPENMP
+		threadId = omp_get_thread_num();
+		noThreads = omp_get_num_threads();
+#endif
+		int chunkBegin = static_cast<int>(static_cast<long long>(noElements) * threadId / noThreads);
+		int chunkEnd = static_cast<int>(static_cast<long long>(noElements) * (threadId + 1) / noThreads);
+
+		// Flag
+		std::vector<int> selected;
+		for (int i = chunkBegin; i < chunkEnd; i++) {
+			if (isSelected(i)) selected.push_back(i);
+		}
+		chunkOffsets[threadId + 1] = static_cast<int>(selected.size());
+
+		// Exclusive scan over the per-thread counts
+#ifdef WITH_OPENMP
+		#pragma omp barrier
+		#pragma omp single
+#endif
+		{
+			for (int t = 0; t < noThreads; t++) chunkOffsets[t + 1] += chunkOffsets[t];
+			noSelected = chunkOffsets[noThreads];
+		}
+
+		// Scatter
+		int offset = chunkOffsets[threadId];
+		for (size_t k = 0; k < selected.size() && offset + static_cast<int>(k) < maxOutput; k++) {
+			scatter(offset + static_cast<int>(k), selected[k]);
+		}
+	}
+
+	return noSelected < maxOutput ? noSelected : maxOutput;
+}
+
+/**
+ * \brief Writes the indices i in [0, noElements) for which isSelected(i) holds to outIndices, in
+ *        increasing order. See compactStream.
+ */
+template <typename TPredicate>
+int compactIndices(int noElements, TPredicate isSelected, int *outIndices,
+				   int maxOutput = std::numeric_limits<int>::max())
+{
+	return compactStream(noElements, isSelected,
+						 [outIndices](int outputIdx, int inputIdx) { outIndices[outputIdx] = inputIdx; },
+						 maxOutput);
+}
+
+}
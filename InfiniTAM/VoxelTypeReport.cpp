@@ -0,0 +1,235 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+// Reports how much accuracy the compact voxel types cost, compared to how much memory they save.
+//
+// The reference sequence is synthetic, so that the true surface is known exactly: a sphere resting
+// on a ground plane, seen by a 320x240 depth camera which orbits it over a number of frames. The
+// depth maps are ray-traced and get Kinect-like noise, which grows quadratically with the depth.
+// Every frame is fused into a dense voxel grid of each voxel type, with the same per-voxel update
+// as ITMSceneReconstructionEngine. The report then lists, for each type:
+//  - its size, and how many blocks fit in 1 GiB;
+//  - the RMS difference of its SDF to the SDF fused with floats, in mm;
+//  - the distance between the zero crossings of its SDF and the true surface, in mm.
+//
+// Usage: InfiniTAM_voxelreport [number of frames, default 60]
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "ITMLib/Engine/DeviceAgnostic/ITMSceneReconstructionEngine.h"
+
+namespace {
+
+const Vector2i imgSize(320, 240);
+const Vector4f projParams(300.0f, 300.0f, 160.0f, 120.0f);
+
+const float voxelSize = 0.01f;
+const float mu = 0.02f;
+const int maxW = 100;
+
+// The grid is centred on the sphere, and reaches a bit below the ground plane.
+const Vector3f sphereCentre(0.0f, 0.0f, 0.0f);
+const float sphereRadius = 0.35f;
+const float groundY = 0.35f;
+const int gridDim = 96;
+const Vector3f gridOrigin(-0.48f, -0.48f, -0.48f);
+
+struct Camera {
+	Matrix4f M;				// world to camera
+	Vector3f position;
+	Vector3f axes[3];		// camera axes, in world coordinates
+};
+
+/// A camera on a circle around the sphere, slightly above it, looking at its centre.
+Camera orbitCamera(float angle) {
+	Camera camera;
+	camera.position = Vector3f(1.6f * sinf(angle), -0.5f, -1.6f * cosf(angle));
+
+	Vector3f forward = (sphereCentre - camera.position).normalised();
+	Vector3f right = cross(Vector3f(0.0f, 1.0f, 0.0f), forward).normalised();
+	Vector3f down = cross(forward, right);
+	camera.axes[0] = right; camera.axes[1] = down; camera.axes[2] = forward;
+
+	camera.M.setIdentity();
+	for (int row = 0; row < 3; row++) {
+		for (int col = 0; col < 3; col++) camera.M.m[row + 4 * col] = camera.axes[row][col];
+		camera.M.m[row + 12] = -dot(camera.axes[row], camera.position);
+	}
+	return camera;
+}
+
+/// Distance along the ray to the first surface, or -1 if the ray misses everything.
+float traceRay(const Vector3f &origin, const Vector3f &dir) {
+	float hit = -1.0f;
+
+	Vector3f oc = origin - sphereCentre;
+	float b = dot(oc, dir), c = dot(oc, oc) - sphereRadius * sphereRadius, a = dot(dir, dir);
+	float disc = b * b - a * c;
+	if (disc >= 0.0f) {
+		float t = (-b - sqrtf(disc)) / a;
+		if (t > 0.0f) hit = t;
+	}
+
+	if (dir.y > 0.0f) {
+		float t = (groundY - origin.y) / dir.y;
+		if (t > 0.0f && (hit < 0.0f || t < hit)) hit = t;
+	}
+
+	return hit;
+}
+
+/// Distance of a point to the true surface.
+float surfaceDistance(const Vector3f &p) {
+	float toSphere = fabsf(length(p - sphereCentre) - sphereRadius);
+	float toGround = fabsf(p.y - groundY);
+	return toSphere < toGround ? toSphere : toGround;
+}
+
+/// Renders the noisy depth map of a camera. Since the rays are not normalised along the optical
+/// axis, the ray parameter is the depth.
+void renderDepth(const Camera &camera, std::mt19937 &rng, std::vector<float> &depth) {
+	std::normal_distribution<float> noise(0.0f, 1.0f);
+
+	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++) {
+		float dx = (x - projParams.z) / projParams.x, dy = (y - projParams.w) / projParams.y;
+		Vector3f dir = camera.axes[0] * dx + camera.axes[1] * dy + camera.axes[2];
+
+		float z = traceRay(camera.position, dir);
+		if (z > 0.0f) {
+			float sigma = 0.0012f + 0.0019f * (z - 0.4f) * (z - 0.4f);
+			z += sigma * noise(rng);
+		}
+		depth[x + y * imgSize.x] = z > 0.0f ? z : -1.0f;
+	}
+}
+
+Vector4f voxelPosition(int x, int y, int z) {
+	return Vector4f(gridOrigin.x + x * voxelSize, gridOrigin.y + y * voxelSize, gridOrigin.z + z * voxelSize, 1.0f);
+}
+
+int voxelIdx(int x, int y, int z) {
+	return x + (y + z * gridDim) * gridDim;
+}
+
+template<class TVoxel>
+class Volume {
+public:
+	std::vector<TVoxel> voxels;
+
+	Volume() : voxels(gridDim * gridDim * gridDim) {}
+
+	void integrate(const Camera &camera, const std::vector<float> &depth) {
+		ITMLib::Engine::WeightParams weightParams;
+
+#ifdef WITH_OPENMP
+		#pragma omp parallel for
+#endif
+		for (int z = 0; z < gridDim; z++) for (int y = 0; y < gridDim; y++) for (int x = 0; x < gridDim; x++) {
+			ComputeUpdatedVoxelInfo<false, TVoxel>::compute(voxels[voxelIdx(x, y, z)], voxelPosition(x, y, z),
+				camera.M, projParams, camera.M, projParams, mu, maxW, depth.data(), imgSize, NULL, imgSize,
+				weightParams);
+		}
+	}
+
+	float sdf(int x, int y, int z) const { return TVoxel::SDF_valueToFloat(voxels[voxelIdx(x, y, z)].sdf); }
+	bool isObserved(int x, int y, int z) const { return voxels[voxelIdx(x, y, z)].w_depth > 0; }
+};
+
+struct Report {
+	double sdfRms = 0.0;
+	double surfaceMean = 0.0, surfaceRms = 0.0, surfaceMax = 0.0;
+	long noCrossings = 0;
+};
+
+template<class TVoxel>
+Report evaluate(const Volume<TVoxel> &volume, const Volume<ITMVoxel_f> &reference) {
+	Report report;
+	long noSdfSamples = 0;
+	const int steps[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+
+	for (int z = 0; z < gridDim; z++) for (int y = 0; y < gridDim; y++) for (int x = 0; x < gridDim; x++) {
+		if (!volume.isObserved(x, y, z)) continue;
+
+		float value = volume.sdf(x, y, z);
+		float referenceValue = reference.sdf(x, y, z);
+		if (fabsf(referenceValue) < 1.0f) {
+			double diff = (value - referenceValue) * mu * 1000.0;
+			report.sdfRms += diff * diff;
+			noSdfSamples++;
+		}
+
+		// Zero crossings along the grid edges to the next voxel in x, y and z, which is where
+		// the raycaster and marching cubes put the surface.
+		for (int axis = 0; axis < 3; axis++) {
+			int nx = x + steps[axis][0], ny = y + steps[axis][1], nz = z + steps[axis][2];
+			if (nx >= gridDim || ny >= gridDim || nz >= gridDim || !volume.isObserved(nx, ny, nz)) continue;
+
+			float nextValue = volume.sdf(nx, ny, nz);
+			if ((value > 0.0f) == (nextValue > 0.0f) || fabsf(value) >= 1.0f || fabsf(nextValue) >= 1.0f) continue;
+
+			float t = value / (value - nextValue);
+			Vector4f p0 = voxelPosition(x, y, z), p1 = voxelPosition(nx, ny, nz);
+			Vector3f crossing = p0.toVector3() + (p1.toVector3() - p0.toVector3()) * t;
+
+			double error = surfaceDistance(crossing) * 1000.0;
+			report.surfaceMean += error;
+			report.surfaceRms += error * error;
+			if (error > report.surfaceMax) report.surfaceMax = error;
+			report.noCrossings++;
+		}
+	}
+
+	report.sdfRms = noSdfSamples > 0 ? sqrt(report.sdfRms / noSdfSamples) : 0.0;
+	if (report.noCrossings > 0) {
+		report.surfaceMean /= report.noCrossings;
+		report.surfaceRms = sqrt(report.surfaceRms / report.noCrossings);
+	}
+	return report;
+}
+
+template<class TVoxel>
+void printReport(const char *name, const Report &report) {
+	size_t blockBytes = sizeof(TVoxel) * SDF_BLOCK_SIZE3;
+	printf("%-14s %6zu %11zu %15zu %12.3f %12.3f %12.3f %12.3f %10ld\n", name, sizeof(TVoxel), blockBytes,
+		   (size_t(1) << 30) / blockBytes, report.sdfRms, report.surfaceMean, report.surfaceRms, report.surfaceMax,
+		   report.noCrossings);
+}
+
+}
+
+int main(int argc, char **argv) {
+	int noFrames = (argc > 1) ? atoi(argv[1]) : 60;
+	if (noFrames < 1) {
+		fprintf(stderr, "The number of frames must be positive.\n");
+		return EXIT_FAILURE;
+	}
+
+	Volume<ITMVoxel_f> volume_f;
+	Volume<ITMVoxel_s> volume_s;
+	Volume<ITMVoxel_u8> volume_u8;
+
+	std::mt19937 rng(42);
+	std::vector<float> depth(imgSize.x * imgSize.y);
+
+	for (int frame = 0; frame < noFrames; frame++) {
+		// Half a turn around the sphere, so that the later frames mostly revisit the surface.
+		Camera camera = orbitCamera(-0.8f + 1.6f * frame / noFrames);
+		renderDepth(camera, rng, depth);
+
+		volume_f.integrate(camera, depth);
+		volume_s.integrate(camera, depth);
+		volume_u8.integrate(camera, depth);
+	}
+
+	printf("%d frames, %d^3 voxels of %.0f mm, mu = %.0f mm\n\n", noFrames, gridDim, voxelSize * 1000.0f, mu * 1000.0f);
+	printf("%-14s %6s %11s %15s %12s %12s %12s %12s %10s\n", "voxel type", "bytes", "block bytes", "blocks per GiB",
+		   "sdf rms mm", "surf mean mm", "surf rms mm", "surf max mm", "crossings");
+	printReport<ITMVoxel_f>("ITMVoxel_f", evaluate(volume_f, volume_f));
+	printReport<ITMVoxel_s>("ITMVoxel_s", evaluate(volume_s, volume_f));
+	printReport<ITMVoxel_u8>("ITMVoxel_u8", evaluate(volume_u8, volume_f));
+
+	return EXIT_SUCCESS;
+}